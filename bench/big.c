@@ -0,0 +1,71 @@
+void main(void) {
+  int i, s, t;
+  s = 0; t = 1; i = 0;
+  if (s > 0) { s = s - 0; } else { t = t + s; }
+  while (i < 5) { i = i + 1; if (t > i) { s = s + 1; } else { t = t + 1; } }
+  if (s > 1) { s = s - 1; } else { t = t + s; }
+  if (s > 2) { s = s - 2; } else { t = t + s; }
+  if (s > 3) { s = s - 3; } else { t = t + s; }
+  if (s > 4) { s = s - 4; } else { t = t + s; }
+  if (s > 5) { s = s - 5; } else { t = t + s; }
+  if (s > 6) { s = s - 6; } else { t = t + s; }
+  if (s > 7) { s = s - 7; } else { t = t + s; }
+  if (s > 8) { s = s - 8; } else { t = t + s; }
+  if (s > 9) { s = s - 9; } else { t = t + s; }
+  if (s > 10) { s = s - 10; } else { t = t + s; }
+  while (i < 15) { i = i + 1; if (t > i) { s = s + 1; } else { t = t + 1; } }
+  if (s > 11) { s = s - 11; } else { t = t + s; }
+  if (s > 12) { s = s - 12; } else { t = t + s; }
+  if (s > 13) { s = s - 13; } else { t = t + s; }
+  if (s > 14) { s = s - 14; } else { t = t + s; }
+  if (s > 15) { s = s - 15; } else { t = t + s; }
+  if (s > 16) { s = s - 16; } else { t = t + s; }
+  if (s > 17) { s = s - 17; } else { t = t + s; }
+  if (s > 18) { s = s - 18; } else { t = t + s; }
+  if (s > 19) { s = s - 19; } else { t = t + s; }
+  if (s > 20) { s = s - 20; } else { t = t + s; }
+  while (i < 25) { i = i + 1; if (t > i) { s = s + 1; } else { t = t + 1; } }
+  if (s > 21) { s = s - 21; } else { t = t + s; }
+  if (s > 22) { s = s - 22; } else { t = t + s; }
+  if (s > 23) { s = s - 23; } else { t = t + s; }
+  if (s > 24) { s = s - 24; } else { t = t + s; }
+  if (s > 25) { s = s - 25; } else { t = t + s; }
+  if (s > 26) { s = s - 26; } else { t = t + s; }
+  if (s > 27) { s = s - 27; } else { t = t + s; }
+  if (s > 28) { s = s - 28; } else { t = t + s; }
+  if (s > 29) { s = s - 29; } else { t = t + s; }
+  if (s > 30) { s = s - 30; } else { t = t + s; }
+  while (i < 35) { i = i + 1; if (t > i) { s = s + 1; } else { t = t + 1; } }
+  if (s > 31) { s = s - 31; } else { t = t + s; }
+  if (s > 32) { s = s - 32; } else { t = t + s; }
+  if (s > 33) { s = s - 33; } else { t = t + s; }
+  if (s > 34) { s = s - 34; } else { t = t + s; }
+  if (s > 35) { s = s - 35; } else { t = t + s; }
+  if (s > 36) { s = s - 36; } else { t = t + s; }
+  if (s > 37) { s = s - 37; } else { t = t + s; }
+  if (s > 38) { s = s - 38; } else { t = t + s; }
+  if (s > 39) { s = s - 39; } else { t = t + s; }
+  if (s > 40) { s = s - 40; } else { t = t + s; }
+  while (i < 45) { i = i + 1; if (t > i) { s = s + 1; } else { t = t + 1; } }
+  if (s > 41) { s = s - 41; } else { t = t + s; }
+  if (s > 42) { s = s - 42; } else { t = t + s; }
+  if (s > 43) { s = s - 43; } else { t = t + s; }
+  if (s > 44) { s = s - 44; } else { t = t + s; }
+  if (s > 45) { s = s - 45; } else { t = t + s; }
+  if (s > 46) { s = s - 46; } else { t = t + s; }
+  if (s > 47) { s = s - 47; } else { t = t + s; }
+  if (s > 48) { s = s - 48; } else { t = t + s; }
+  if (s > 49) { s = s - 49; } else { t = t + s; }
+  if (s > 50) { s = s - 50; } else { t = t + s; }
+  while (i < 55) { i = i + 1; if (t > i) { s = s + 1; } else { t = t + 1; } }
+  if (s > 51) { s = s - 51; } else { t = t + s; }
+  if (s > 52) { s = s - 52; } else { t = t + s; }
+  if (s > 53) { s = s - 53; } else { t = t + s; }
+  if (s > 54) { s = s - 54; } else { t = t + s; }
+  if (s > 55) { s = s - 55; } else { t = t + s; }
+  if (s > 56) { s = s - 56; } else { t = t + s; }
+  if (s > 57) { s = s - 57; } else { t = t + s; }
+  if (s > 58) { s = s - 58; } else { t = t + s; }
+  if (s > 59) { s = s - 59; } else { t = t + s; }
+  print(s); print(t);
+}
@@ -0,0 +1,25 @@
+int add3(int a, int b, int c) {
+  return a + b + c;
+}
+int sq(int x) {
+  return x * x;
+}
+int fib(int n) {
+  if (n < 2) {
+    return n;
+  }
+  return fib(n - 1) + fib(n - 2);
+}
+void main(void) {
+  int r;
+  r = add3(1, sq(2), add3(sq(3), 4, 5));
+  print(r);
+  print(sq(r) - r * 2);
+  print(fib(12));
+  int j = 0;
+  while (j < 5) {
+    int t = sq(j) + j;
+    print(t);
+    j = j + 1;
+  }
+}
@@ -0,0 +1,9 @@
+int count(int n, int acc) {
+  if (n == 0) {
+    return acc;
+  }
+  return count(n - 1, acc + 2);
+}
+void main(void) {
+  print(count(5000, 0));
+}
@@ -0,0 +1,14 @@
+int fact(int n) {
+  if (n < 2) {
+    return 1;
+  }
+  return n * fact(n - 1);
+}
+void main(void) {
+  int i;
+  i = 1;
+  while (i < 8) {
+    print(fact(i));
+    i = i + 1;
+  }
+}
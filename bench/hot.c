@@ -0,0 +1,14 @@
+void main(void) {
+  int i, s, t;
+  i = 0; s = 0;
+  while (i < 100000) {
+    t = i * 3;
+    if (t > 100) {
+      s = s + 1;
+    } else {
+      s = s - 1;
+    }
+    i = i + 1;
+  }
+  print(s);
+}
@@ -0,0 +1,43 @@
+int g(int x) {
+  return x + 1;
+}
+void main(void) {
+  int a, b, c;
+  a = 0;
+  b = 5;
+  c = 3;
+  if (a && g(b)) {
+    print(1);
+  } else {
+    print(2);
+  }
+  if (b && c) {
+    print(3);
+  } else {
+    print(4);
+  }
+  if (a || c) {
+    print(5);
+  } else {
+    print(6);
+  }
+  if (a || 0) {
+    print(7);
+  } else {
+    print(8);
+  }
+  if (b > 2 && c < 4 || a == 1) {
+    print(9);
+  } else {
+    print(10);
+  }
+  int i = 0;
+  while (i < 10 && i * i < 30) {
+    i = i + 1;
+  }
+  print(i);
+  print(b - -c);
+  print(b * 6 / 4 - c * 16);
+  print(0 - 7 / 2);
+  print(100 / 8 * 3);
+}
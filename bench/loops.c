@@ -0,0 +1,29 @@
+void main(void) {
+  int a, b, c, i, s;
+  a = 7;
+  b = 3;
+  i = 0;
+  s = 0;
+  while (i < 20) {
+    c = a * b + 4;
+    s = s + c - i * 2;
+    i = i + 1;
+  }
+  print(s);
+  i = 0;
+  while (i < 10 - 2) {
+    s = s - a * 8 / 4;
+    i = i + 1;
+  }
+  print(s);
+  int k = 100;
+  while (k > 0) {
+    k = k - 7;
+    if (k / 2 * 2 == k) {
+      print(k);
+    } else {
+      s = s + 1;
+    }
+  }
+  print(s);
+}
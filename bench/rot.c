@@ -0,0 +1,19 @@
+void main(void) {
+  int i, s, f;
+  i = 0; s = 0;
+  while (i < 1000) {
+    s = s + i;
+    i = i + 1;
+  }
+  print(s);
+  f = 3;
+  while (f) {
+    f = f - 1;
+    print(f);
+  }
+  i = 0;
+  while (i < 5 && s > 0) {
+    i = i + 1;
+  }
+  print(i);
+}
@@ -0,0 +1,37 @@
+int g(int x) {
+  int k;
+  k = 3;
+  if (k > 2) {
+    return x * k;
+  } else {
+    return 0;
+  }
+}
+void main(void) {
+  int a, b, c, i;
+  a = 5;
+  b = a * 2;
+  if (b == 10) {
+    c = 1;
+  } else {
+    c = 2;
+  }
+  print(c);
+  i = 0;
+  while (i < 3) {
+    if (a > 100) {
+      print(999);
+    } else {
+      print(i + c);
+    }
+    i = i + 1;
+  }
+  c = c + b;
+  print(c);
+  print(g(c));
+  i = 0;
+  while (a < 3) {
+    print(888);
+  }
+  print(7 / 2);
+}
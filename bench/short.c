@@ -0,0 +1,37 @@
+int side(int x) {
+  print(x);
+  return x;
+}
+void main(void) {
+  int a, b, c, i, r;
+  a = 0;
+  b = 1;
+  c = 2;
+  if (a && side(7)) {
+    print(100);
+  } else {
+    print(101);
+  }
+  if (b || side(8)) {
+    print(102);
+  } else {
+    print(0);
+  }
+  if (a || side(9)) {
+    print(103);
+  } else {
+    print(104);
+  }
+  r = (a || b) && (c || side(10));
+  print(r);
+  r = a && b || c;
+  print(r);
+  r = (a && side(11)) || (b && side(12));
+  print(r);
+  i = 0;
+  while (i < 5 && (i != 3 || a)) {
+    print(i);
+    i = i + 1;
+  }
+  print(side(0) || side(0));
+}
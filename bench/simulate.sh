@@ -0,0 +1,57 @@
+#!/bin/bash
+# Run the benchmarks on the simulator and print their instructions,
+# cycles, loads and stores, for the register allocation and the
+# scheduling of the cross assembler.
+#
+# usage: bench/simulate.sh [compiler options] [cross assembler options] [file.c...]
+#
+# The options of the cross assembler, --no-schedule, --interlocked,
+# --depth=n and --latency=OP:n, are given to it, the other options to
+# the compiler. The programs are those of bench/ by default. The compiler
+# and the simulator must have been built in symbol_table, see its
+# Makefile.
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+SRC=$BENCH/../symbol_table
+
+OPTIONS=()
+XA_OPTIONS=()
+FILES=()
+for arg in "$@"; do
+  case $arg in
+    --no-schedule|--interlocked|--depth=*|--latency=*) XA_OPTIONS+=("$arg") ;;
+    -*) OPTIONS+=("$arg") ;;
+    *) FILES+=("$(cd "$(dirname "$arg")" && pwd)/$(basename "$arg")") ;;
+  esac
+done
+if [ ${#FILES[@]} -eq 0 ]; then
+  FILES=("$BENCH"/*.c)
+fi
+if [ ! -x "$SRC/c" ] || [ ! -x "$SRC/sim" ]; then
+  echo "error: build the compiler and the simulator first, make -C symbol_table c sim"
+  exit 1
+fi
+
+# The compiler and the cross assembler write their files in the current directory
+WORK=`mktemp -d`
+trap "rm -rf $WORK" EXIT
+cd $WORK
+
+printf "%-12s %12s %12s %10s %10s\n" Program Instructions Cycles Loads Stores
+for f in "${FILES[@]}"; do
+  name=`basename $f`
+  if ! "$SRC/c" "${OPTIONS[@]}" < $f > compile.log 2>&1; then
+    echo "$name: compilation failed"
+    continue
+  fi
+  if ! python3 "$SRC/crossassembler.py" "${XA_OPTIONS[@]}" > assembler.log 2>&1; then
+    echo "$name: assembly failed"
+    continue
+  fi
+  "$SRC/sim" asm.bin > simulation.log 2>&1
+  # Simulation of asm.bin: n instruction(s) in n cycle(s), CPI x
+  # Memory accesses: n load(s), n store(s)
+  awk -v name=$name '/^Simulation of/ { instructions = $4; cycles = $7 }
+                     /^Memory accesses:/ { loads = $3; stores = $5 }
+                     END { printf "%-12s %12d %12d %10d %10d\n", name, instructions, cycles, loads, stores }' simulation.log
+done
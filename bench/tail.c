@@ -0,0 +1,19 @@
+int sum(int n, int acc) {
+  if (n == 0) {
+    return acc;
+  }
+  return sum(n - 1, acc + n);
+}
+int gcd(int a, int b) {
+  if (b == 0) {
+    return a;
+  }
+  return gcd(b, a - (a / b) * b);
+}
+void main(void) {
+  print(sum(10, 0));
+  print(sum(40, 0));
+  print(gcd(1071, 462));
+  int x = sum(5, 100) + 1;
+  print(x);
+}
@@ -0,0 +1,59 @@
+#!/bin/bash
+# Count the jumps taken when running the benchmarks: the JMP executed and
+# the JMF which jumped, read from the profile written by the interpreter.
+#
+# usage: bench/taken_jumps.sh [--train] [compiler options] [file.c...]
+#
+# The programs are those of bench/ by default. With --train, each program
+# is first compiled with -O1 and run with --profile, and its profile is
+# given to the compiler with --profile-use. The compiler must have been
+# built in symbol_table, see its Makefile.
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+SRC=$BENCH/../symbol_table
+
+TRAIN=0
+OPTIONS=()
+FILES=()
+for arg in "$@"; do
+  case $arg in
+    --train) TRAIN=1 ;;
+    -*) OPTIONS+=("$arg") ;;
+    *) FILES+=("$(cd "$(dirname "$arg")" && pwd)/$(basename "$arg")") ;;
+  esac
+done
+if [ ${#FILES[@]} -eq 0 ]; then
+  FILES=("$BENCH"/*.c)
+fi
+if [ ! -x "$SRC/c" ]; then
+  echo "error: build the compiler first, make -C symbol_table c"
+  exit 1
+fi
+
+# The compiler and the interpreter write their files in the current directory
+WORK=`mktemp -d`
+trap "rm -rf $WORK" EXIT
+cd $WORK
+
+total=0
+for f in "${FILES[@]}"; do
+  name=`basename $f`
+  use=()
+  if [ $TRAIN -eq 1 ]; then
+    "$SRC/c" -O1 < $f > /dev/null 2>&1 && python3 "$SRC/interpreter.py" --max-iter=0 --profile=train.txt > /dev/null
+    use=(--profile-use=train.txt)
+  fi
+  if ! "$SRC/c" "${OPTIONS[@]}" "${use[@]}" < $f > compile.log 2>&1; then
+    echo "$name: compilation failed"
+    continue
+  fi
+  python3 "$SRC/interpreter.py" --max-iter=0 --profile=profile.txt > /dev/null
+  # A JMP runs as many times as the block it ends, as split by the interpreter
+  jumps=`awk 'BEGIN { index_ = 0 } FNR == NR { if ($1 == "B") count[$2] = $5; else if ($1 == "J") taken += $6; next }
+              $0 ~ /^[ \t]*($|#|\.)/ { next }
+              { if (index_ in count) block = count[index_]; if ($1 == "JMP") taken += block; index_++ }
+              END { print taken + 0 }' profile.txt asm.txt`
+  printf "%-12s %8d\n" $name $jumps
+  total=$((total + jumps))
+done
+printf "%-12s %8d\n" total $total
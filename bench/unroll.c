@@ -0,0 +1,49 @@
+int id(int x) {
+  return x;
+}
+void main(void) {
+  int i, n, s, k;
+  n = id(23);
+  i = 0; s = 0;
+  while (i < n) {
+    s = s + i * 3;
+    i = i + 1;
+  }
+  print(s);
+  i = 0; s = 0;
+  while (i < 10) {
+    s = s + i;
+    i = i + 2;
+  }
+  print(s);
+  k = 100; s = 0;
+  while (k > n) {
+    s = s + k;
+    k = k - 7;
+  }
+  print(s);
+  print(k);
+  i = n; s = 0;
+  while (n + 40 >= i) {
+    s = s + 1;
+    i = i + 3;
+  }
+  print(s);
+  i = 0; s = 0;
+  while (i <= 1000) {
+    s = s + id(i);
+    i = i + 1;
+  }
+  print(s);
+  i = 0;
+  while (i < 3) {
+    print(i);
+    i = i + 1;
+  }
+  i = n; s = 0;
+  while (i < n + 2) {
+    s = s + 5;
+    i = i + 1;
+  }
+  print(s);
+}
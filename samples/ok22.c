@@ -0,0 +1,12 @@
+int sum(int n, int acc) {
+  if (n == 0) {
+    return acc;
+  }
+  return sum(n - 1, acc + n); // Tail call, runs in a constant stack
+}
+
+void main(void) { // Prints 5050
+  int s;
+  s = sum(100, 0);
+  print(s);
+}
@@ -0,0 +1,11 @@
+int f0(int a, int b) {
+  return 8 + b;
+}
+
+void main(void) { // Prints 9
+  int v = 0;
+  if (1) {
+    v = -(256); // Leaves a temporary in the block
+  }
+  print(f0(16, 0) + 1); // The result of the call must not be overwritten
+}
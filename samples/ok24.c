@@ -0,0 +1,10 @@
+int g(int a, int b, int c) {
+  return a * 100 + b * 10 + c;
+}
+
+void main(void) { // Prints 123, -3, 123 and 1
+  print(g(1, 2, 3));
+  print(g(0, 0, -(3))); // The argument of the negation is not left under the argument
+  print(g(g(0, 0, 1), 2, g(0, 0, 3))); // Nested calls
+  print(g(0, 0, 1) == 1);
+}
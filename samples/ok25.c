@@ -0,0 +1,27 @@
+int p(int x) {
+  print(x);
+  return x;
+}
+
+void main(void) { // Prints 0, 1, 40, 10, 11, 12, 3, 5 and 1
+  int zero = 0;
+  int one = 1;
+  int a = 0;
+  int i = 0;
+  a = zero && p(1); // p is not called
+  print(a);
+  a = one || p(2); // p is not called
+  print(a);
+  if (zero && p(3)) {
+    print(30);
+  }
+  if (one || p(4)) {
+    print(40);
+  }
+  while (i < 3 && p(i + 10)) { // p is not called once i is 3
+    i = i + 1;
+  }
+  print(i);
+  a = one && p(5); // p is called
+  print(a);
+}
@@ -0,0 +1,21 @@
+int show(int x) {
+  print(x / 2); // Rounds toward zero, not toward minus infinity
+  print(x / 4);
+  print(x * 3); // Multiplications by constants which are not powers of two
+  print(x * 5);
+  print(x * 6);
+  print(x * 7);
+  print(x * 9);
+  return 0;
+}
+
+void main(void) { // Prints -3, -1, -21, -35, -42, -49, -63, then -4, -2, -24, -40, -48, -56, -72, then 3, 1, 21, 35, 42, 49, 63 and 0, 0
+  int i = -1;
+  show(-7);
+  show(-8);
+  show(7);
+  while (i < 1) { // -1 / 8 is 0, not -1
+    print(i / 8);
+    i = i + 1;
+  }
+}
@@ -0,0 +1,20 @@
+// Options: --passes=coloring,licm,strength
+int g(int x) {
+  return x - 30;
+}
+
+int f(int a) {
+  int s = g(a); // a is dead after the call, its frame must not start at slot 0
+  int i = 3;
+  int r = 0;
+  while (i > 0) {
+    r = r + s * 2; // Hoisted by LICM into a new slot
+    i = i - 1;
+  }
+  s = s / 2; // Needs a new slot for the rounding of the division
+  return r + s;
+}
+
+void main(void) { // Prints -260
+  print(f(-10));
+}
@@ -0,0 +1,27 @@
+int g(int x) {
+  print(x);
+  return x;
+}
+
+int run(int a, int b) {
+  int i = 0;
+  int s = 0;
+  int t = 0;
+  while (i < 10) {
+    s = s + a * b + i; // a * b does not change in the loop
+    t = a - 10; // Read after the loop
+    i = i + 1;
+  }
+  print(s);
+  i = 0;
+  while (i < 2) {
+    print(a * 2); // The print and the call stay in the loop
+    s = g(b) + 1;
+    i = i + 1;
+  }
+  return t + s;
+}
+
+void main(void) { // Prints 255, 14, 3, 14, 3 and 1
+  print(run(7, 3));
+}
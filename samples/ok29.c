@@ -0,0 +1,17 @@
+int g(int x) {
+  print(x);
+  return x;
+}
+
+int f(int a, int b) {
+  int x = (a - 1) * (a - 1) + (a - 1); // a - 1 is computed once
+  int y = a * b + a * b;
+  a = a + 1; // a - 1 must be computed again
+  int z = a - 1;
+  int w = g(b) + g(b); // Both calls print
+  return x + y + z + w;
+}
+
+void main(void) { // Prints 3, 3 and 61
+  print(f(5, 3));
+}
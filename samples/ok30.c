@@ -0,0 +1,12 @@
+int f(int x, int y) {
+  print(1 + (2 * (3 + (x * y)))); // Right-leaning, the deeper operand is evaluated first
+  print(x - (y - (x * (y + 2)))); // Not commutative, the order of the operands stays
+  print((x + 1) * ((y - 2) * ((x + 3) / (y - 5))));
+  print(100 / (x - (3 - (y * 2))));
+  print((1 + x) < (y * (2 + x)));
+  return x - (y * (x + (y * 3)));
+}
+
+void main(void) { // Prints 63, 33, 75, 6, 1 and -171
+  print(f(4, 7));
+}
@@ -0,0 +1,26 @@
+int f(int i, int j) {
+  return i * 10 + j;
+}
+
+void main(void) { // Prints 32, 16, 26, 1, 1, 0, 0 and 19
+  int a = 4;
+  int b = 6;
+  int v = f(3, 1) + 1; // The ADD writes straight to v
+  print(v);
+  a = b - (a - 14); // The destination is also an operand
+  print(a);
+  a = (a + 5) * 2 - a; // The operands are read before the result is written
+  print(a);
+  v = a / 20;
+  print(v);
+  b = (a > 3 && v < 5); // A logical operation writes its value with two AFC
+  print(b);
+  b = (a < 3 || v > 5);
+  print(b);
+  a = b;
+  print(a);
+  while (a < 20) {
+    a = a + 10;
+  }
+  print(a + v - 2);
+}
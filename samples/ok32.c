@@ -0,0 +1,36 @@
+int g(int x) {
+  int k = 3;
+  if (k > 2) { // Always true, the else branch is removed
+    return x * k;
+  } else {
+    return 0;
+  }
+}
+
+void main(void) { // Prints 1, 1, 2, 3, 11, 33 and 3
+  int a = 5;
+  int b = a * 2;
+  int c = 0;
+  int i = 0;
+  if (b == 10) {
+    c = 1;
+  } else {
+    c = 2; // Never executed, c is the constant 1 after the if
+  }
+  print(c);
+  while (i < 3) {
+    if (a > 100) {
+      print(999);
+    } else {
+      print(i + c); // i is not constant
+    }
+    i = i + 1;
+  }
+  while (a < 3) { // Never entered
+    print(888);
+  }
+  c = c + b;
+  print(c);
+  print(g(c));
+  print(7 / 2);
+}
@@ -0,0 +1,38 @@
+int test(int i, int n) {
+  print(i); // The condition is evaluated once more than the body
+  return i < n;
+}
+
+void main(void) { // Prints 0, 1, 2, 3, 0, 3, 5, 2, 1, 0 and 6
+  int i = 0;
+  int j = 0;
+  int s = 0;
+  while (test(i, 3)) { // Rotated: a test before the loop, one at the bottom
+    i = i + 1;
+  }
+  i = 0;
+  while (i < 0) { // Never entered
+    i = i + 1;
+  }
+  print(i);
+  while (i < 5 && s >= 0) {
+    i = i + 1;
+  }
+  print(s + 3);
+  print(i);
+  j = 3;
+  while (j) {
+    j = j - 1;
+    print(j);
+  }
+  i = 0;
+  while (i < 3) { // Nested loops
+    j = 0;
+    while (j < i) {
+      s = s + 1;
+      j = j + 1;
+    }
+    i = i + 1;
+  }
+  print(s + s);
+}
@@ -0,0 +1,50 @@
+int sum(int n) {
+  int i = 0;
+  int s = 0;
+  while (i < n) { // Unknown trip count: unrolled with a remainder loop
+    s = s + i * 3;
+    i = i + 1;
+  }
+  return s;
+}
+
+void main(void) { // Prints 0, 0, 3, 759, 20, 715, 23, 14, 0, 1, 2 and 10
+  int i = 0;
+  int s = 0;
+  int k = 100;
+  print(sum(0));
+  print(sum(1));
+  print(sum(2));
+  print(sum(23));
+  while (i < 10) { // Constant trip count with a step of 2: fully unrolled
+    s = s + i;
+    i = i + 2;
+  }
+  print(s);
+  s = 0;
+  while (k > 23) { // Decreasing counter
+    s = s + k;
+    k = k - 7;
+  }
+  print(s);
+  print(k);
+  i = 23;
+  s = 0;
+  while (63 >= i) {
+    s = s + 1;
+    i = i + 3;
+  }
+  print(s);
+  i = 0;
+  while (i < 3) {
+    print(i);
+    i = i + 1;
+  }
+  i = 0;
+  s = 0;
+  while (i <= 1) {
+    s = s + 5;
+    i = i + 1;
+  }
+  print(s);
+}
@@ -0,0 +1,25 @@
+// Options: --passes=layout,unroll,coloring,sccp,licm,strength,lvn,coloring,strength,sethi-ullman,licm
+int g(int x) {
+  return x - 30;
+}
+
+int f(int a, int n) {
+  int s = g(a);
+  int i = 0;
+  int r = 0;
+  while (i < n) {
+    r = r + s * 3 + i / 4;
+    i = i + 1;
+  }
+  s = s / 2;
+  return r + s;
+}
+
+void main(void) { // Prints -20, -20, -738, -1614 and 2
+  int k = 4;
+  print(f(-10, 0));
+  print(g(k + 6));
+  print(f(-10, 6));
+  print(f(k, 21) - 2 * k);
+  print(k / 2);
+}
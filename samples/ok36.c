@@ -0,0 +1,15 @@
+int mix(int a, int b, int c, int d) {
+  int x = a * b + c * d; // Independent products, scheduled between the loads
+  int y = (a - d) * (b + c);
+  int z = x / (c + 1) - y * 2;
+  return x + y + z;
+}
+
+void main(void) { // Prints 142, 74, 104 and 144
+  int i = 0;
+  print(mix(3, 5, 4, 11));
+  while (i < 3) {
+    print(mix(i, i + 1, i + 2, i + 3) * 2 + 40);
+    i = i + 1;
+  }
+}
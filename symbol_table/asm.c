@@ -17,6 +17,14 @@
 #include "instructions_table.h"
 #include "functions_table.h"
 
+/**
+ * @brief Instruction address of the function being generated
+ * 
+ * It is used to recognize the calls of a function to itself, so
+ * that a tail call can reuse the frame of the current function.
+ */
+int current_function_address = -1;
+
 /**
  * @brief A macro to generate the assembly code for a binary operation
  * 
@@ -65,34 +73,140 @@ ASSEMBLE_BINARY_OP(lt, iLT)   // Less than
 ASSEMBLE_BINARY_OP(gt, iGT)   // Greater than
 ASSEMBLE_BINARY_OP(le, iLE)   // Less than or equal
 ASSEMBLE_BINARY_OP(ge, iGE)   // Greater than or equal
-ASSEMBLE_BINARY_OP(and, iAND) // Logical AND
-ASSEMBLE_BINARY_OP(or, iOR)   // Logical OR
+
+//
+// SHORT-CIRCUIT LOGICAL OPERATIONS
+//
+
+/**
+ * @brief Index of the end of the last logical operation
+ * 
+ * A logical operation ends with AFC result 1, JMP end, AFC result 0,
+ * its true jumps reaching the first AFC and its false jumps the second.
+ * If the operation is used as a condition right after, this end is
+ * removed and its jumps are used directly.
+ */
+int last_condition_end = -1;
+
+/* Patch a chain of jumps with their target */
+static void asm_patch_chain(int chain, int target) {
+    while(chain != -1) {
+        int next = it_get_target(chain);
+        it_set_target(chain, target);
+        chain = next;
+    }
+}
+
+/* Append a chain of jumps to another one */
+static int asm_merge_chains(int chain1, int chain2) {
+    if(chain1 == -1) {
+        return chain2;
+    }
+    int last = chain1;
+    while(it_get_target(last) != -1) {
+        last = it_get_target(last);
+    }
+    it_set_target(last, chain2);
+    return chain1;
+}
+
+/* Check if an expression is the logical operation just generated, still in its temporary */
+static int asm_is_condition(int address) {
+    int end = it_get_index() - 3;
+    return st_is_tmp(address) && end >= 0 && end == last_condition_end
+        && it_get(end).opcode == iAFC && it_get(end).op1 == address
+        && it_get(end+2).opcode == iAFC && it_get(end+2).op1 == address;
+}
+
+/* Remove the end of the logical operation just generated, returns its false jumps */
+static int asm_condition_jumps(int address) {
+    int end = it_get_index() - 3;
+    it_rollback(end);
+    last_condition_end = -1;
+    if(st_is_tmp(address)) {st_pop_tmp();}
+
+    // The true jumps now reach the next instruction, chain the false ones
+    int chain = -1;
+    for(int i = current_function_address; i < end; i++) {
+        if(it_get(i).opcode == iJMPF && it_get(i).op2 == end + 2) {
+            it_patch_op2(i, chain);
+            chain = i;
+        }
+    }
+    return chain;
+}
+
+/* Jumps taken when an expression is false */
+static int asm_condition_operand(int address) {
+    if(asm_is_condition(address)) {
+        return asm_condition_jumps(address);
+    }
+    if(st_is_tmp(address)) {st_pop_tmp();}
+    return it_insert(iJMPF, address, -1, 0);
+}
+
+/* Logical operation end: 1 or 0 in a temporary variable */
+static int asm_condition_end(int line_number, int true_chain, int false_chain, int depth) {
+    int address = st_insert_tmp(0, line_number, depth);
+    asm_patch_chain(true_chain, it_get_index());
+    last_condition_end = it_insert(iAFC, address, 1, 0);
+    it_insert(iJMP, last_condition_end + 3, 0, 0);
+    asm_patch_chain(false_chain, it_insert(iAFC, address, 0, 0));
+    return address;
+}
+
+/* Logical AND first operand */
+int asm_and_prepare(int address1) {
+    printf("expression with tAND '%d'\n", address1);
+    // Skip the second operand if the first one is false
+    return asm_condition_operand(address1);
+}
+
+/* Logical AND */
+int asm_and_patch(int line_number, int chain, int address2, int depth) {
+    int false_chain = asm_merge_chains(chain, asm_condition_operand(address2));
+    return asm_condition_end(line_number, -1, false_chain, depth);
+}
+
+/* Logical OR first operand */
+int asm_or_prepare(int address1) {
+    printf("expression with tOR '%d'\n", address1);
+    // Skip the second operand if the first one is true
+    int false_chain = asm_condition_operand(address1);
+    int true_chain = it_insert(iJMP, -1, 0, 0);
+    asm_patch_chain(false_chain, it_get_index());
+    return true_chain;
+}
+
+/* Logical OR */
+int asm_or_patch(int line_number, int chain, int address2, int depth) {
+    return asm_condition_end(line_number, chain, asm_condition_operand(address2), depth);
+}
 
 
 void asm_init() {
     // By default, the main function is the entry point of the program
-    // The first instruction sets the return address to -1 so that the program stops
-    it_insert(iAFC, 0, -1, 0);
+    // Its LEAVE finds the return stack empty, which stops the program
     it_insert(iJMP, -1, 0, 0);
 }
 
 void asm_main_start(int line_number, int depth) {
     // Update the instruction index of the main function to jump to the main function
     // when the program starts
-    it_patch_op1(1,it_get_index());
+    it_patch_op1(0,it_get_index());
 
     // Insert main function in the function table
+    current_function_address = it_get_index();
     ft_insert("main", it_get_index());
-    st_insert("?ADRMain", line_number, depth);
     st_insert("?VALMain", line_number, depth);
 }
 
 void asm_main_end(int depth) {
     // Remove everything from the symbol table
-    // Should only remain the return address and value
+    // Should only remain the return value
     st_pop_depth(depth);
     printf("void main(void)\n");
-    it_insert(iRET, 0, 0, 0);
+    it_insert(iLEAVE, 0, 0, 0);
     it_insert(iNOP, 0, 0, 0);
 }
 
@@ -115,13 +229,37 @@ int asm_nb(int line_number, int address1, int depth){
     return a;
 }
 
+/* Make the last operation of an expression write to its destination */
+static int asm_set_destination(int destination, int address) {
+    int last = it_get_index() - 1;
+    if(!st_is_tmp(address) || last < 0 || it_get(last).op1 != address) {
+        return 0;
+    }
+    // A logical operation gives its value with two AFC
+    if(asm_is_condition(address)) {
+        it_patch_op1(last - 2, destination);
+        it_patch_op1(last, destination);
+        return 1;
+    }
+    // The operands are read before the result is written, so the
+    // destination may also be an operand
+    enum opcode opc = it_get(last).opcode;
+    if(opc != iAFC && opc != iCOP && (opc < iADD || opc > iOR)) {
+        return 0;
+    }
+    it_patch_op1(last, destination);
+    return 1;
+}
+
 /* Variable assignment */
 void asm_assign(char* address1, int address2){
     printf("instruction with tID %s and expression %d\n", address1, address2);
     
     // Get the address of the variable to assign to
     int a=st_search(address1);
-    it_insert(iCOP, a, address2, 0);
+    if(!asm_set_destination(a, address2)) {
+        it_insert(iCOP, a, address2, 0);
+    }
     if(st_is_tmp(address2)) {st_pop_tmp();}
 
     // st_pop_tmp(); // Pop the result of the expression
@@ -132,12 +270,15 @@ void asm_assign(char* address1, int address2){
 /* Number negation */
 int asm_neg_nb(int line_number, int address1, int depth){
     printf("expression with tSUB\n");
-    // Create a temporary symbol for the result
+    // Free the operand so that it does not stay under the result
+    if(st_is_tmp(address1)) {st_pop_tmp();}
+    // Create a temporary symbol for the result, and one for 0 above it
     int address = st_insert_tmp(0, line_number, depth);
-    // Store 0 in the result
-    it_insert(iAFC, address, 0 , 0);
+    int zero = st_insert_tmp(0, line_number, depth);
+    it_insert(iAFC, zero, 0 , 0);
     // Subtract the number from 0(0 - number = -number)
-    it_insert(iSOU, address, address, address1);
+    it_insert(iSOU, address, zero, address1);
+    st_pop_tmp();
     return address;
 }
 
@@ -159,59 +300,59 @@ void asm_print(int address1) {
 void asm_function_new_start(char* name, int line_number, int depth) {
     printf("function int '%s'\n", name);
     // Add the function to the function table
+    current_function_address = it_get_index();
     ft_insert(name, it_get_index());
-    // Insert return and value address in the symbol table
-    st_insert("?ADR", line_number, depth);
+    // Insert the return value in the symbol table, the return address
+    // is kept by ENTER on the return stack
     st_insert("?VAL", line_number, depth);
 }
 
 void asm_function_new_end(int nb_params) {
+    ft_set_nb_params(current_function_address, nb_params);
+
     // Remove the parameters from the symbol table
     for(int i = 0; i < nb_params; i++) {
     st_pop();
     }
 
-    // Remove the return address and value from the symbol table
-    st_pop();
+    // Remove the return value from the symbol table
     st_pop();
 
-    it_insert(iRET, 0, 0, 0);
+    it_insert(iLEAVE, 0, 0, 0);
 }
 
 /* Function preparation */
 int asm_function_prepare_stack(int line_number, int depth) {
     int tsp = st_get_count(); // Get the symbol table size (stack size)
     
-    // Insert return address and value
-    st_insert("!ADR", line_number, depth);
-    st_insert("!VAL", line_number, depth);
+    // Insert return value, named after its slot since the calls may be nested
+    char str[16];
+    sprintf(str, "!VAL%d", tsp);
+    st_insert(str, line_number, depth);
 
     return tsp;
 }
 
 /* Function call */
-int asm_function_call(char* name, int tsp, int depth) {
-    // Create new frame for the function call
-      it_insert(iPUSH, tsp, 0, 0);
-      it_insert(iCALL, ft_search(name), 0, 0);
-      it_insert(iPOP, tsp, 0, 0);
-
-      // Remove the return address and value from the symbol table
-      st_pop();
-      st_pop();      
-
-      // Remove the badly managed symbols
-      // Should not remove anything, but just in case
-      st_pop_depth(depth);
+int asm_function_call(char* name, int tsp, int line_number, int depth) {
+    // Call the function in a new frame starting at tsp
+      it_insert(iENTER, ft_search(name), tsp, 0);
+
+      // Remove the return value and the arguments from the symbol table.
+      // Only the symbols above tsp are removed: the temporaries left below
+      // it by the enclosing blocks are part of the frame of the caller
+      while(st_get_count() > tsp) {
+        st_pop();
+      }
 
+      // The return value of the function is at the start of its frame, tsp,
+      // it is kept as a temporary so that the expression does not overwrite it
+      int iVAL = st_insert_tmp(0, line_number, depth - 1);
 
-      // Get the return value of the function to use it in the expression
-      int iVAL = st_get_count();
-      
       printf("function call: %s(params)\n", name);
-      st_print(); // Print the symbol table, should not contain the function call symbols
+      st_print(); // Print the symbol table, should only contain the return value of the call
 
-      return iVAL+1;
+      return iVAL;
 }
 
 /* Function call arguments */
@@ -222,7 +363,7 @@ void asm_function_call_arg(int address, int arg_index, int line_number, int dept
       // If the expression is a variable, we can use it directly
       // and copy its value to the argument variable reserved in the stack
       // 
-      // Argument name is arg0, arg1, arg2, etc.      
+      // Argument name is arg0_slot, arg1_slot, etc., unique when the calls are nested
       if(st_is_tmp(address))
       {
         st_pop();
@@ -234,22 +375,32 @@ void asm_function_call_arg(int address, int arg_index, int line_number, int dept
         // Insert the expression in the symbol table as a new variable
         char str[16];
 
-        sprintf(str, "arg%d", arg_index);
+        sprintf(str, "arg%d_%d", arg_index, st_get_count());
         st_insert(str, line_number, depth);
       } else {
         // Copy the value of the variable to the argument variable reserved in the stack
         char str[16];
-        sprintf(str, "arg%d", arg_index);
+        sprintf(str, "arg%d_%d", arg_index, st_get_count());
         int res = st_insert(str, line_number, depth);
         it_insert(iCOP, res, address, 0);
       }
 }
 
 /* Function return */
-void asm_function_return(int expression_address, int depth) {
+void asm_function_return(int expression_address, int nb_params, int depth) {
       // Get ?VAL address
       st_print();
 
+      // A self tail call has just been generated as ENTER f tsp
+      // and its return value is returned as is: reuse the current frame
+      int call = it_get_index() - 1;
+      if(call >= 0
+          && it_get(call).opcode == iENTER && it_get(call).op1 == current_function_address
+          && expression_address == it_get(call).op2) {
+        asm_function_tail_call(it_get(call).op2, nb_params, depth);
+        return;
+      }
+
       // Get the return value of the current function
       // and insert the expression in the return value
       int iVAL = st_search("?VAL");
@@ -258,22 +409,41 @@ void asm_function_return(int expression_address, int depth) {
       // Should not remove anything, but just in case
       st_pop_depth(depth);
 
-      // Return to the return address
-      it_insert(iRET, 0, 0, 0);
+      // Return to the caller
+      it_insert(iLEAVE, 0, 0, 0);
       printf("instruction with tRETURN and expression\n");
 }
 
+/* Self tail call */
+void asm_function_tail_call(int tsp, int nb_params, int depth) {
+      // Remove the ENTER of the call
+      it_rollback(it_get_index() - 1);
+
+      // Overwrite the parameters with the arguments. The arguments are
+      // above the parameters in the frame, so they can be copied in order
+      int first_param = st_search("?VAL") + 1;
+      for(int i = 0; i < nb_params; i++) {
+        it_insert(iCOP, first_param + i, tsp + 1 + i, 0);
+      }
+
+      // Should not remove anything, but just in case
+      st_pop_depth(depth);
+
+      // Restart the function: the return stack still holds the first caller
+      it_insert(iJMP, current_function_address, 0, 0);
+      printf("instruction with tRETURN and tail call\n");
+}
+
 /* If preparatino*/
 int asm_if_prepare(int expression_address) {
-    if(st_is_tmp(expression_address)) {st_pop_tmp();}
-    return it_insert(iJMPF, expression_address, -1, 0); 
+    return asm_condition_operand(expression_address);
 }
 
 /* If patch*/
 void asm_if_patch(int jmp_address) {
-    // Update the line number of the JMPF instruction
+    // Update the line number of the JMPF instructions
     int current = it_get_index();
-    it_patch_op2(jmp_address, current+1);
+    asm_patch_chain(jmp_address, current+1);
 }
 
 /* Else preparation */
@@ -296,17 +466,81 @@ void asm_else_empty() {
     it_insert(iNOP, 0, 0, 0);
 }
 
+/* While start */
+int asm_while_start() {
+    // The condition is evaluated again from here at each iteration
+    return it_get_index();
+}
+
 /* While preparation */
 int asm_while_prepare(int expression_address) {
-    return it_insert(iJMPF, expression_address, -1, 0); 
+    return asm_condition_operand(expression_address);
 }
 
-/* While patch */
-void asm_while_patch(int jmp_address) {
-    // Update the line number of the JMPF instruction
-    it_patch_op2(jmp_address, it_get_index()+1);
-    // JMP to the entry of while loop again after executing body
-    it_insert(iJMP, jmp_address-1, 0, 0);
-    st_pop_tmp(); // @TODO: check if this is correct,we need to pop 
-    // the temporary variable from the stack at a moment but idk when
+/* Opcode of the opposite comparison, -1 if not a comparison */
+static int asm_invert_comparison(enum opcode opc) {
+    switch(opc) {
+        case iEQ: return iNEQ;
+        case iNEQ: return iEQ;
+        case iLT: return iGE;
+        case iGE: return iLT;
+        case iGT: return iLE;
+        case iLE: return iGT;
+        default: return -1;
+    }
 }
+
+/* Check if the condition of a while statement can be copied after the body */
+static int asm_while_can_rotate(int start_address, int jmp_address) {
+    // A logical operation has its own jumps, it is not copied
+    if(it_get(jmp_address).opcode != iJMPF || it_get_target(jmp_address) != -1
+            || jmp_address - start_address > WHILE_ROTATION_MAX) {
+        return 0;
+    }
+    for(int i = start_address; i < jmp_address; i++) {
+        if(it_get(i).opcode == iJMP || it_get(i).opcode == iJMPF) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* While patch */
+void asm_while_patch(int start_address, int jmp_address, int line_number, int depth) {
+    if(!asm_while_can_rotate(start_address, jmp_address)) {
+        // Update the line number of the JMPF instructions
+        asm_patch_chain(jmp_address, it_get_index()+1);
+        // JMP to the entry of while loop again after executing body
+        it_insert(iJMP, start_address, 0, 0);
+        return;
+    }
+
+    // Test the condition again after the body and go back to the body
+    // while it is true. JMPF jumps when its operand is false, so the
+    // copy of the condition is inverted.
+    int condition = it_get(jmp_address).op1;
+    for(int i = start_address; i < jmp_address; i++) {
+        struct_instruction in = it_get(i);
+        it_insert(in.opcode, in.op1, in.op2, in.op3);
+    }
+    int last = it_get_index() - 1;
+    int computed = jmp_address > start_address && it_get(last).op1 == condition;
+    if(computed && asm_invert_comparison(it_get(last).opcode) != -1) {
+        struct_instruction in = it_get(last);
+        in.opcode = asm_invert_comparison(in.opcode);
+        it_set(last, in);
+    } else if(computed) {
+        it_insert(iNOT, condition, 0, 0);
+    } else {
+        // The condition is a variable, it is inverted in a temporary variable
+        int address = st_insert_tmp(0, line_number, depth);
+        st_pop_tmp();
+        it_insert(iCOP, address, condition, 0);
+        it_insert(iNOT, address, 0, 0);
+        condition = address;
+    }
+    it_insert(iJMPF, condition, jmp_address + 1, 0);
+
+    // The condition at the start jumps after the loop when false
+    it_patch_op2(jmp_address, it_get_index());
+}
\ No newline at end of file
@@ -204,27 +204,65 @@ int asm_le(int line_number, int address1, int address2, int depth);
  */
 int asm_ge(int line_number, int address1, int address2, int depth);
 
+/**
+ * @brief Generate the assembly code for the first operand of a logical AND
+ * 
+ * The logical operations are short-circuited: the second operand is not
+ * evaluated if the first one gives the result. This function inserts a
+ * JMPF taken when the first operand is false. If the first operand is
+ * itself a logical operation, its jumps are reused instead.
+ * 
+ * The JMPF taken when the operation is false are chained through their
+ * jump address, -1 ending the chain, until the operation ends.
+ * 
+ * @param address1 the address of the first operand
+ * @return int the chain of the jumps taken when the operation is false
+ */
+int asm_and_prepare(int address1);
+
 /**
  * @brief Generate the assembly code for a logical AND operation
  * 
+ * This function ends a logical AND: it jumps to false if the second
+ * operand is false, then gives the value of the operation, 1 or 0, to
+ * a temporary variable with AFC result 1, JMP end, AFC result 0.
+ * 
+ * When the result is used as a condition or as an operand of another
+ * logical operation, this end is removed so that the jumps go directly
+ * to the true and false targets, see asm_if_prepare.
+ * 
  * @param line_number   the line number in the code
- * @param address1      the address of the first operand
+ * @param chain         the chain given by asm_and_prepare
  * @param address2      the address of the second operand
  * @param depth         the depth of the symbol table
  * @return int the address of the result
  */
-int asm_and(int line_number, int address1, int address2, int depth);
+int asm_and_patch(int line_number, int chain, int address2, int depth);
+
+/**
+ * @brief Generate the assembly code for the first operand of a logical OR
+ * 
+ * This function inserts a JMP taken when the first operand is true, so
+ * that the second operand is not evaluated. The JMP taken when the
+ * operation is true are chained like for asm_and_prepare.
+ * 
+ * @param address1 the address of the first operand
+ * @return int the chain of the jumps taken when the operation is true
+ */
+int asm_or_prepare(int address1);
 
 /**
  * @brief Generate the assembly code for a logical OR operation
  * 
+ * This function ends a logical OR like asm_and_patch.
+ * 
  * @param line_number   the line number in the code
- * @param address1      the address of the first operand
+ * @param chain         the chain given by asm_or_prepare
  * @param address2      the address of the second operand
  * @param depth         the depth of the symbol table
  * @return int the address of the result
  */
-int asm_or(int line_number, int address1, int address2, int depth);
+int asm_or_patch(int line_number, int chain, int address2, int depth);
 
 
 //
@@ -263,6 +301,10 @@ int asm_nb(int line_number, int address1, int depth);
  * This function generates the assembly code for a variable assignment.
  * It assigns the value of the second operand to the first operand.
  * 
+ * If the expression has just been computed into a temporary variable,
+ * its last operation writes the variable directly instead of copying
+ * the temporary variable with a COP.
+ * 
  * @param address1 the address of the first operand
  * @param address2 the address of the second operand
  */
@@ -346,14 +388,17 @@ int asm_function_prepare_stack(int line_number, int depth);
  * @brief Generate the assembly code for a function call
  * 
  * This function generates the assembly code for a function call.
- * It pushes the arguments on the stack and calls the function.
+ * A single ENTER calls the function in a frame starting at tsp, where
+ * the return value is found after the call. The return value is a
+ * temporary variable of the enclosing scope.
  * 
  * @param name          the name of the function
  * @param tsp           the top of the stack pointer before the call
+ * @param line_number   the line number in the code
  * @param depth         the depth of the symbol table
  * @return int the address of the result
  */
-int asm_function_call(char* name, int tsp, int depth);
+int asm_function_call(char* name, int tsp, int line_number, int depth);
 
 /**
  * @brief Generate the assembly code for arguments
@@ -375,10 +420,31 @@ void asm_function_call_arg(int address, int arg_index, int line_number, int dept
  * This function generates the assembly code for a function return.
  * It copies the return value to the return adress
  * 
+ * If the returned expression is a call of the current function to
+ * itself, the call is replaced by a tail call, see asm_function_tail_call.
+ * 
  * @param expression_address the address of the expression
+ * @param nb_params the number of parameters of the current function
  * @param depth the depth of the symbol table
  */
-void asm_function_return(int expression_address, int depth);
+void asm_function_return(int expression_address, int nb_params, int depth);
+
+/**
+ * @brief Generate the assembly code for a self tail call
+ * 
+ * This function replaces the ENTER instruction of a call of the
+ * current function to itself, which has just been generated. The
+ * arguments are copied over the parameters of the current frame and a
+ * JMP goes back to the entry of the function. Nothing is pushed on the
+ * return stack, so the final LEAVE goes
+ * directly back to the first caller. Recursion in tail position then
+ * runs in a constant stack.
+ * 
+ * @param tsp the top of the stack pointer of the call
+ * @param nb_params the number of parameters of the current function
+ * @param depth the depth of the symbol table
+ */
+void asm_function_tail_call(int tsp, int nb_params, int depth);
 
 
 //
@@ -390,10 +456,11 @@ void asm_function_return(int expression_address, int depth);
  * 
  * This function generates the assembly code for an if statement.
  * It prepares the if statement by inserting the JMPF instruction
- * in the instruction table.
+ * in the instruction table. If the condition is a logical operation,
+ * its own jumps are used instead, without computing its value.
  * 
  * @param expression_address the address of the expression
- * @return int the address of the instruction
+ * @return int the chain of the jumps to patch, see asm_and_prepare
 
  */
 int asm_if_prepare(int expression_address);
@@ -403,7 +470,7 @@ int asm_if_prepare(int expression_address);
  * 
  * This function generates the assembly code for an if statement PATCH.
  * It patches the jump address of the if statement.
- * @param jmp_address 
+ * @param jmp_address the chain of the jumps to patch
  */
 void asm_if_patch(int jmp_address);
 
@@ -442,15 +509,33 @@ void asm_else_empty();
 // WHILE STATEMENTS
 //
 
+/**
+ * @brief Constant for the maximum number of instructions of a condition
+ * copied after the body of a while statement
+ */
+#define WHILE_ROTATION_MAX 16
+
+/**
+ * @brief Generate the assembly code for the start of a while statement
+ * 
+ * This function gives the address of the first instruction of the
+ * condition of the while statement, where the loop goes back after
+ * executing the body.
+ * 
+ * @return int the address of the first instruction of the condition
+ */
+int asm_while_start();
+
 /**
  * @brief Generate the assembly code for a while statement
  * 
  * This function generates the assembly code for a while statement.
  * It prepares the while statement by inserting the JMP instruction
- * in the instruction table.
+ * in the instruction table. Like for asm_if_prepare, a logical
+ * operation uses its own jumps.
  * 
  * @param expression_address the address of the expression
- * @return int the address of the instruction
+ * @return int the chain of the jumps to patch
  */
 int asm_while_prepare(int expression_address);
 
@@ -458,10 +543,20 @@ int asm_while_prepare(int expression_address);
  * @brief Generate the assembly code for a while statement PATCH
  * 
  * This function generates the assembly code for a while statement PATCH.
- * It patches the jump address of the while statement.
+ * The loop is rotated: the condition is copied after the body, inverted,
+ * and a JMPF goes back to the body while it is true. The condition at
+ * the start only guards the entry of the loop, so that each iteration
+ * executes one jump instead of a JMPF and a JMP.
  * 
- * @param jmp_address the address of the jump instruction
+ * A condition with its own jumps, like a logical operation, or longer
+ * than WHILE_ROTATION_MAX instructions is not copied: the JMPF of the
+ * condition is patched and a JMP goes back to the condition.
+ * 
+ * @param start_address the address of the first instruction of the condition
+ * @param jmp_address the chain of the jumps to patch
+ * @param line_number the line number of the while statement
+ * @param depth the depth of the while statement
  */
-void asm_while_patch(int jmp_address);
+void asm_while_patch(int start_address, int jmp_address, int line_number, int depth);
 
 #endif // ASM_H 
\ No newline at end of file
@@ -0,0 +1,171 @@
+/**
+ * @file bitset.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the bitsets
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "bitset.h"
+
+#if !defined(BITSET_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define BS_AVX2
+#elif !defined(BITSET_NO_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define BS_SSE2
+#endif
+
+/* Check if an element is in a bitset */
+bool bs_test(const bitset_word* set, int bit) {
+    return (set[bit / BS_WORD_BITS] >> (bit % BS_WORD_BITS)) & 1;
+}
+
+/* Add an element to a bitset */
+void bs_set(bitset_word* set, int bit) {
+    set[bit / BS_WORD_BITS] |= (bitset_word)1 << (bit % BS_WORD_BITS);
+}
+
+/* Remove an element from a bitset */
+void bs_reset(bitset_word* set, int bit) {
+    set[bit / BS_WORD_BITS] &= ~((bitset_word)1 << (bit % BS_WORD_BITS));
+}
+
+/* Add a range of elements to a bitset */
+void bs_set_range(bitset_word* set, int from, int to) {
+    // Bit by bit up to a word boundary, then whole words
+    while(from < to && from % BS_WORD_BITS != 0) {
+        bs_set(set, from++);
+    }
+    while(from + BS_WORD_BITS <= to) {
+        set[from / BS_WORD_BITS] = ~(bitset_word)0;
+        from += BS_WORD_BITS;
+    }
+    while(from < to) {
+        bs_set(set, from++);
+    }
+}
+
+/* Set every word of a bitset to a value */
+void bs_fill(bitset_word* set, bitset_word value, int words) {
+    for(int w = 0; w < words; w++) {
+        set[w] = value;
+    }
+}
+
+/* Copy a bitset */
+void bs_copy(bitset_word* dst, const bitset_word* src, int words) {
+    for(int w = 0; w < words; w++) {
+        dst[w] = src[w];
+    }
+}
+
+/* Union of two bitsets */
+void bs_union(bitset_word* dst, const bitset_word* src, int words) {
+    int w = 0;
+#if defined(BS_AVX2)
+    for(; w + 4 <= words; w += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + w));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + w));
+        _mm256_storeu_si256((__m256i*)(dst + w), _mm256_or_si256(a, b));
+    }
+#elif defined(BS_SSE2)
+    for(; w + 2 <= words; w += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + w));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + w));
+        _mm_storeu_si128((__m128i*)(dst + w), _mm_or_si128(a, b));
+    }
+#endif
+    for(; w < words; w++) {
+        dst[w] |= src[w];
+    }
+}
+
+/* Intersection of two bitsets */
+void bs_intersect(bitset_word* dst, const bitset_word* src, int words) {
+    int w = 0;
+#if defined(BS_AVX2)
+    for(; w + 4 <= words; w += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + w));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + w));
+        _mm256_storeu_si256((__m256i*)(dst + w), _mm256_and_si256(a, b));
+    }
+#elif defined(BS_SSE2)
+    for(; w + 2 <= words; w += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + w));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + w));
+        _mm_storeu_si128((__m128i*)(dst + w), _mm_and_si128(a, b));
+    }
+#endif
+    for(; w < words; w++) {
+        dst[w] &= src[w];
+    }
+}
+
+/* Difference of two bitsets */
+void bs_subtract(bitset_word* dst, const bitset_word* src, int words) {
+    int w = 0;
+#if defined(BS_AVX2)
+    for(; w + 4 <= words; w += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(dst + w));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(src + w));
+        _mm256_storeu_si256((__m256i*)(dst + w), _mm256_andnot_si256(b, a));
+    }
+#elif defined(BS_SSE2)
+    for(; w + 2 <= words; w += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(dst + w));
+        __m128i b = _mm_loadu_si128((const __m128i*)(src + w));
+        _mm_storeu_si128((__m128i*)(dst + w), _mm_andnot_si128(b, a));
+    }
+#endif
+    for(; w < words; w++) {
+        dst[w] &= ~src[w];
+    }
+}
+
+/* Transfer function of a dataflow analysis, returns true if dst changed */
+bool bs_transfer(bitset_word* dst, const bitset_word* gen, const bitset_word* src, const bitset_word* kill, int words) {
+    int w = 0;
+    bitset_word changed = 0;
+#if defined(BS_AVX2)
+    __m256i diff = _mm256_setzero_si256();
+    for(; w + 4 <= words; w += 4) {
+        __m256i g = _mm256_loadu_si256((const __m256i*)(gen + w));
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + w));
+        __m256i k = _mm256_loadu_si256((const __m256i*)(kill + w));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + w));
+        __m256i r = _mm256_or_si256(g, _mm256_andnot_si256(k, s));
+        diff = _mm256_or_si256(diff, _mm256_xor_si256(r, d));
+        _mm256_storeu_si256((__m256i*)(dst + w), r);
+    }
+    changed = !_mm256_testz_si256(diff, diff);
+#elif defined(BS_SSE2)
+    __m128i diff = _mm_setzero_si128();
+    for(; w + 2 <= words; w += 2) {
+        __m128i g = _mm_loadu_si128((const __m128i*)(gen + w));
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + w));
+        __m128i k = _mm_loadu_si128((const __m128i*)(kill + w));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + w));
+        __m128i r = _mm_or_si128(g, _mm_andnot_si128(k, s));
+        diff = _mm_or_si128(diff, _mm_xor_si128(r, d));
+        _mm_storeu_si128((__m128i*)(dst + w), r);
+    }
+    changed = _mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF;
+#endif
+    for(; w < words; w++) {
+        bitset_word r = gen[w] | (src[w] & ~kill[w]);
+        changed |= r ^ dst[w];
+        dst[w] = r;
+    }
+    return changed != 0;
+}
+
+/* Count the elements of a bitset */
+int bs_count(const bitset_word* set, int words) {
+    int count = 0;
+    for(int w = 0; w < words; w++) {
+        count += __builtin_popcountll(set[w]);
+    }
+    return count;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file bitset.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the bitsets
+ *
+ * A bitset is an array of words, one bit per element. The sets of the
+ * dataflow analyses are bitsets, so that an operation on two sets works
+ * on 64 elements at once.
+ *
+ * The operations on whole sets use the SSE2 or AVX2 instructions when the
+ * compiler targets them (-msse2, -mavx2), 128 or 256 elements at once.
+ * Defining BITSET_NO_SIMD keeps the portable version.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <stdbool.h> // bool type
+#include <stdint.h>  // uint64_t
+
+/**
+ * @brief Type of a word of a bitset
+ */
+typedef uint64_t bitset_word;
+
+/**
+ * @brief Constant for the number of bits of a word
+ */
+#define BS_WORD_BITS 64
+
+/**
+ * @brief Number of words of a bitset of n elements
+ */
+#define BS_WORDS(n) (((n) + BS_WORD_BITS - 1) / BS_WORD_BITS)
+
+/**
+ * @brief Check if an element is in a bitset
+ *
+ * @param set the bitset
+ * @param bit the element
+ * @return true if the element is in the bitset
+ */
+bool bs_test(const bitset_word* set, int bit);
+
+/**
+ * @brief Add an element to a bitset
+ *
+ * @param set the bitset
+ * @param bit the element
+ */
+void bs_set(bitset_word* set, int bit);
+
+/**
+ * @brief Remove an element from a bitset
+ *
+ * @param set the bitset
+ * @param bit the element
+ */
+void bs_reset(bitset_word* set, int bit);
+
+/**
+ * @brief Add a range of elements to a bitset
+ *
+ * @param set the bitset
+ * @param from the first element
+ * @param to the element after the last one
+ */
+void bs_set_range(bitset_word* set, int from, int to);
+
+/**
+ * @brief Set every word of a bitset to a value
+ *
+ * @param set the bitset
+ * @param value the value of the words, 0 for the empty set, ~0 for the full set
+ * @param words the number of words of the bitset
+ */
+void bs_fill(bitset_word* set, bitset_word value, int words);
+
+/**
+ * @brief Copy a bitset
+ *
+ * @param dst the copy
+ * @param src the copied bitset
+ * @param words the number of words of the bitsets
+ */
+void bs_copy(bitset_word* dst, const bitset_word* src, int words);
+
+/**
+ * @brief Union of two bitsets, dst = dst | src
+ *
+ * @param dst the first bitset, updated
+ * @param src the second bitset
+ * @param words the number of words of the bitsets
+ */
+void bs_union(bitset_word* dst, const bitset_word* src, int words);
+
+/**
+ * @brief Intersection of two bitsets, dst = dst & src
+ *
+ * @param dst the first bitset, updated
+ * @param src the second bitset
+ * @param words the number of words of the bitsets
+ */
+void bs_intersect(bitset_word* dst, const bitset_word* src, int words);
+
+/**
+ * @brief Difference of two bitsets, dst = dst & ~src
+ *
+ * @param dst the first bitset, updated
+ * @param src the second bitset
+ * @param words the number of words of the bitsets
+ */
+void bs_subtract(bitset_word* dst, const bitset_word* src, int words);
+
+/**
+ * @brief Transfer function of a dataflow analysis, dst = gen | (src & ~kill)
+ *
+ * @param dst the result
+ * @param gen the elements generated
+ * @param src the elements before the transfer
+ * @param kill the elements killed
+ * @param words the number of words of the bitsets
+ * @return true if dst changed
+ */
+bool bs_transfer(bitset_word* dst, const bitset_word* gen, const bitset_word* src, const bitset_word* kill, int words);
+
+/**
+ * @brief Count the elements of a bitset
+ *
+ * @param set the bitset
+ * @param words the number of words of the bitset
+ * @return int the number of elements
+ */
+int bs_count(const bitset_word* set, int words);
+
+#endif // BITSET_H
@@ -11,9 +11,10 @@
   #include "asm.h"
   #include "instructions_table.h"
   #include "functions_table.h"
+  #include "pass_manager.h"
+  #include "token_stream.h"
 
 
-  extern int line_number; // Defined in lex.c
   int depth = 0;          // Scope depth
   int nb_params = 0;      // Number of parameters in a function
   int nb_args = 0;        // Number of arguments in a function call
@@ -31,6 +32,7 @@
 %token <n> tIF tELSE
 %token <n> tWHILE
 %token <n> tLPAR
+%token <n> tAND tOR
 
 %token tMAIN tPRINT tRETURN tINT tVOID tASSIGN tRPAR tLBRACE tRBRACE tCOMMA tSEMI tERROR
 
@@ -84,7 +86,7 @@ FunctionCall :
     {
       depth++;       // New scope
       int tsp = asm_function_prepare_stack(line_number, depth);
-      $$ = asm_function_call($1, tsp, depth);
+      $$ = asm_function_call($1, tsp, line_number, depth);
       depth--;       // Go back to the previous scope
     }
   | tID tLPAR 
@@ -93,7 +95,7 @@ FunctionCall :
       $2 = asm_function_prepare_stack(line_number, depth);
     } ParameterCall tRPAR 
     {
-      $$ = asm_function_call($1, $2, depth);
+      $$ = asm_function_call($1, $2, line_number, depth);
       depth--;       // Go back to the previous scope
       nb_args = 0;   // Reset for the next function call
     }
@@ -125,17 +127,17 @@ Expression :
   | Expression tGE Expression  { $$ = asm_ge(line_number, $1, $3, depth);}
   | tSUB Expression            { $$ = asm_neg_nb(line_number, $2, depth);}
   | tNOT Expression            { $$ = asm_not(line_number, $2, depth);}
-  | Expression tAND Expression { $$ = asm_and(line_number, $1, $3, depth);}
-  | Expression tOR Expression  { $$ = asm_or(line_number, $1, $3, depth);}
+  | Expression tAND { $2 = asm_and_prepare($1); } Expression { $$ = asm_and_patch(line_number, $2, $4, depth);}
+  | Expression tOR { $2 = asm_or_prepare($1); } Expression  { $$ = asm_or_patch(line_number, $2, $4, depth);}
   ;
 
 Instruction : 
     tID tASSIGN Expression tSEMI          { asm_assign($1, $3); }
-  | FunctionCall tSEMI                    { printf("instruction with function call\n");}
-  | tRETURN Expression tSEMI              { asm_function_return($2, depth); }
+  | FunctionCall tSEMI                    { if(st_is_tmp($1)) {st_pop_tmp();} printf("instruction with function call\n");}
+  | tRETURN Expression tSEMI              { asm_function_return($2, nb_params, depth); }
   | tPRINT tLPAR Expression tRPAR tSEMI   { asm_print($3); }
   | tIF tLPAR Expression tRPAR LBRACE     { $1 = asm_if_prepare($3);   } Body { asm_if_patch($1); } RBRACE ElsePart
-  | tWHILE tLPAR Expression tRPAR LBRACE  { $1 = asm_while_prepare($3);} Body RBRACE { asm_while_patch($1); }
+  | tWHILE { $1 = asm_while_start(); } tLPAR Expression tRPAR LBRACE { $3 = asm_while_prepare($4);} Body RBRACE { asm_while_patch($1, $3, line_number, depth); }
   ;
 
 ElsePart : 
@@ -172,13 +174,27 @@ void yyerror(const char *msg) {
   exit(1);
 }
 
-int main(void) {
+int main(int argc, char** argv) {
+  if(!pm_parse_args(argc, argv)) {
+    pm_usage(argv[0]);
+    return 1;
+  }
+  if(!ts_start()) {
+    return 1;
+  }
   yyparse();
+  ts_finish();
+
+  // Optimize the instructions table
+  if(pm_run() < 0) {
+    return 1;
+  }
 
   // Print all the tables
   st_print();
   it_pretty_print();
   it_print_asm();
+  it_print_map();
   ft_print();
 }
 
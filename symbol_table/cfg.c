@@ -0,0 +1,283 @@
+/**
+ * @file cfg.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the control flow graph
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "cfg.h"
+#include <string.h> // memset, memcpy
+#include "functions_table.h"
+
+/* Get the instructions range of a function */
+void cfg_get_function_range(int function, int* start, int* end) {
+    *start = ft_search_by_address(function).memory_address;
+    if(function + 1 < ft_get_count()) {
+        *end = ft_search_by_address(function + 1).memory_address;
+    } else {
+        *end = it_get_index();
+    }
+}
+
+/* Get the block of an instruction, binary search on the block starts */
+int cfg_block_of(struct_cfg* cfg, int index) {
+    if(index < cfg->start || index >= cfg->end) {
+        return -1;
+    }
+    int low = 0, high = cfg->nb_blocks - 1;
+    while(low < high) {
+        int mid = (low + high + 1) / 2;
+        if(cfg->blocks[mid].start <= index) {
+            low = mid;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return low;
+}
+
+/* Add a successor to a block, without duplicates */
+static void cfg_add_succ(struct_block* block, int succ) {
+    if(succ == -1) {
+        return;
+    }
+    for(int i = 0; i < block->nb_succ; i++) {
+        if(block->succ[i] == succ) {
+            return;
+        }
+    }
+    block->succ[block->nb_succ++] = succ;
+}
+
+/* Compute the reverse postorder of the reachable blocks */
+static void cfg_compute_order(struct_cfg* cfg) {
+    static int stack[CFG_MAX_BLOCKS];
+    static int next_succ[CFG_MAX_BLOCKS];
+    static bool visited[CFG_MAX_BLOCKS];
+    static int postorder[CFG_MAX_BLOCKS];
+    int nb_post = 0;
+
+    memset(visited, 0, sizeof(bool) * cfg->nb_blocks);
+    int top = 0;
+    stack[top++] = 0;
+    next_succ[0] = 0;
+    visited[0] = true;
+    while(top > 0) {
+        int b = stack[top-1];
+        if(next_succ[b] < cfg->blocks[b].nb_succ) {
+            int s = cfg->blocks[b].succ[next_succ[b]++];
+            if(!visited[s]) {
+                visited[s] = true;
+                next_succ[s] = 0;
+                stack[top++] = s;
+            }
+        } else {
+            postorder[nb_post++] = b;
+            top--;
+        }
+    }
+
+    cfg->nb_reachable = nb_post;
+    for(int i = 0; i < nb_post; i++) {
+        cfg->order[i] = postorder[nb_post - 1 - i];
+        cfg->blocks[cfg->order[i]].rpo = i;
+    }
+}
+
+/* Intersect two dominators paths (Cooper, Harvey and Kennedy) */
+static int cfg_intersect(struct_cfg* cfg, int a, int b) {
+    while(a != b) {
+        while(cfg->blocks[a].rpo > cfg->blocks[b].rpo) {
+            a = cfg->blocks[a].idom;
+        }
+        while(cfg->blocks[b].rpo > cfg->blocks[a].rpo) {
+            b = cfg->blocks[b].idom;
+        }
+    }
+    return a;
+}
+
+/* Compute the immediate dominators of the reachable blocks */
+static void cfg_compute_dominators(struct_cfg* cfg) {
+    // The entry is its own dominator while iterating
+    cfg->blocks[0].idom = 0;
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(int i = 1; i < cfg->nb_reachable; i++) {
+            int b = cfg->order[i];
+            int idom = -1;
+            for(int p = 0; p < cfg->nb_blocks; p++) {
+                if(cfg->blocks[p].rpo == -1 || cfg->blocks[p].idom == -1) {
+                    continue;
+                }
+                for(int s = 0; s < cfg->blocks[p].nb_succ; s++) {
+                    if(cfg->blocks[p].succ[s] == b) {
+                        idom = idom == -1 ? p : cfg_intersect(cfg, p, idom);
+                    }
+                }
+            }
+            if(idom != cfg->blocks[b].idom) {
+                cfg->blocks[b].idom = idom;
+                changed = true;
+            }
+        }
+    }
+    cfg->blocks[0].idom = -1;
+}
+
+/* Build the control flow graph of a range of instructions */
+void cfg_build(struct_cfg* cfg, int start, int end) {
+    static bool leader[INSTRUCTIONS_TABLE_SIZE];
+    cfg->start = start;
+    cfg->end = end;
+    cfg->nb_blocks = 0;
+    cfg->nb_reachable = 0;
+    if(start >= end) {
+        return;
+    }
+
+    // Find the first instruction of each block
+    memset(leader, 0, sizeof(leader));
+    leader[start] = true;
+    for(int i = start; i < end; i++) {
+        enum opcode opc = it_get(i).opcode;
+        if(opc == iJMP || opc == iJMPF) {
+            int target = it_get_target(i);
+            if(target >= start && target < end) {
+                leader[target] = true;
+            }
+        }
+        if((opc == iJMP || opc == iJMPF || opc == iLEAVE) && i + 1 < end) {
+            leader[i+1] = true;
+        }
+    }
+
+    // Split the instructions into blocks
+    for(int i = start; i < end; i++) {
+        if(leader[i]) {
+            struct_block* block = &cfg->blocks[cfg->nb_blocks++];
+            block->start = i;
+            block->nb_succ = 0;
+            block->idom = -1;
+            block->rpo = -1;
+        }
+        cfg->blocks[cfg->nb_blocks-1].end = i + 1;
+    }
+
+    // Link the blocks
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        struct_block* block = &cfg->blocks[b];
+        int last = block->end - 1;
+        enum opcode opc = it_get(last).opcode;
+        if(opc == iJMP || opc == iJMPF) {
+            cfg_add_succ(block, cfg_block_of(cfg, it_get_target(last)));
+        }
+        if(opc != iJMP && opc != iLEAVE && b + 1 < cfg->nb_blocks) {
+            cfg_add_succ(block, b + 1);
+        }
+    }
+
+    cfg_compute_order(cfg);
+    cfg_compute_dominators(cfg);
+}
+
+/* Check if a block dominates another one */
+bool cfg_dominates(struct_cfg* cfg, int a, int b) {
+    if(cfg->blocks[b].rpo == -1) {
+        return false;
+    }
+    while(b != -1) {
+        if(a == b) {
+            return true;
+        }
+        b = cfg->blocks[b].idom;
+    }
+    return false;
+}
+
+/* Find the natural loops, inner loops first */
+int cfg_find_loops(struct_cfg* cfg, struct_loop* loops) {
+    static int stack[CFG_MAX_BLOCKS];
+    int nb_loops = 0;
+
+    for(int u = 0; u < cfg->nb_blocks; u++) {
+        for(int s = 0; s < cfg->blocks[u].nb_succ; s++) {
+            int h = cfg->blocks[u].succ[s];
+            if(!cfg_dominates(cfg, h, u)) {
+                continue;
+            }
+
+            // Back edge u -> h: find or create the loop of the header
+            int l = 0;
+            while(l < nb_loops && loops[l].header != h) {
+                l++;
+            }
+            if(l == nb_loops) {
+                if(nb_loops == CFG_MAX_LOOPS) {
+                    continue;
+                }
+                nb_loops++;
+                loops[l].header = h;
+                memset(loops[l].body, 0, sizeof(loops[l].body));
+                loops[l].body[h] = true;
+                loops[l].nb_blocks = 1;
+            }
+
+            // Walk the predecessors back from u up to the header
+            int top = 0;
+            if(!loops[l].body[u]) {
+                loops[l].body[u] = true;
+                loops[l].nb_blocks++;
+                stack[top++] = u;
+            }
+            while(top > 0) {
+                int b = stack[--top];
+                for(int p = 0; p < cfg->nb_blocks; p++) {
+                    if(loops[l].body[p] || cfg->blocks[p].rpo == -1) {
+                        continue;
+                    }
+                    for(int ps = 0; ps < cfg->blocks[p].nb_succ; ps++) {
+                        if(cfg->blocks[p].succ[ps] == b) {
+                            loops[l].body[p] = true;
+                            loops[l].nb_blocks++;
+                            stack[top++] = p;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Inner loops first
+    for(int i = 1; i < nb_loops; i++) {
+        for(int j = i; j > 0 && loops[j].nb_blocks < loops[j-1].nb_blocks; j--) {
+            static struct_loop tmp;
+            memcpy(&tmp, &loops[j], sizeof(struct_loop));
+            memcpy(&loops[j], &loops[j-1], sizeof(struct_loop));
+            memcpy(&loops[j-1], &tmp, sizeof(struct_loop));
+        }
+    }
+    return nb_loops;
+}
+
+/* Apply the effects of an instruction to the live slots, backwards */
+void cfg_transfer(int index, bool* live) {
+    struct_effects e = it_get_effects(index);
+    for(int d = 0; d < e.nb_defs; d++) {
+        if(e.defs[d] >= 0 && e.defs[d] < CFG_MAX_SLOTS) {
+            live[e.defs[d]] = false;
+        }
+    }
+    for(int u = 0; u < e.nb_uses; u++) {
+        if(e.uses[u] >= 0 && e.uses[u] < CFG_MAX_SLOTS) {
+            live[e.uses[u]] = true;
+        }
+    }
+    for(int u = e.use_from; u >= 0 && u < CFG_MAX_SLOTS && (e.use_to == -1 || u < e.use_to); u++) {
+        live[u] = true;
+    }
+}
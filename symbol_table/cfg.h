@@ -0,0 +1,170 @@
+/**
+ * @file cfg.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the control flow graph
+ *
+ * The control flow graph (CFG) of a function splits the instructions
+ * of the function into basic blocks. A basic block is a sequence of
+ * instructions that is always executed from its first instruction to
+ * its last one. The edges of the graph are the jumps and fall-throughs
+ * between the blocks.
+ *
+ * The CFG is built over the instructions table, from the functions
+ * table: a function starts at its memory address and ends where the
+ * next function starts. On top of it, the dominators and the natural
+ * loops are computed. They are used by the dataflow analyses, see
+ * dataflow.h, and by the optimizations of the instructions table.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdbool.h> // bool type
+#include "instructions_table.h"
+
+/**
+ * @brief Constant for the maximum number of blocks of a function
+ */
+#define CFG_MAX_BLOCKS INSTRUCTIONS_TABLE_SIZE
+
+/**
+ * @brief Constant for the maximum number of memory slots of a frame
+ *
+ * Slots above this limit are not tracked by the analyses, the
+ * optimizations give up on the instructions that use them.
+ */
+#define CFG_MAX_SLOTS 512
+
+/**
+ * @brief Constant for the maximum number of loops of a function
+ */
+#define CFG_MAX_LOOPS 64
+
+/**
+ * @brief Structure for a basic block
+ *
+ * @param start the index of the first instruction of the block
+ * @param end the index after the last instruction of the block
+ * @param succ the successors of the block, -1 if none
+ * @param nb_succ the number of successors
+ * @param idom the immediate dominator, -1 for the entry and unreachable blocks
+ * @param rpo the reverse postorder number, -1 if the block is unreachable
+ */
+typedef struct {
+    int start;
+    int end;
+    int succ[2];
+    int nb_succ;
+    int idom;
+    int rpo;
+} struct_block;
+
+/**
+ * @brief Structure for the control flow graph of a function
+ *
+ * The first block is the entry of the function.
+ *
+ * @param start the index of the first instruction of the function
+ * @param end the index after the last instruction of the function
+ * @param blocks the basic blocks, in the order of the instructions
+ * @param nb_blocks the number of blocks
+ * @param order the reachable blocks in reverse postorder
+ * @param nb_reachable the number of reachable blocks
+ */
+typedef struct {
+    int start;
+    int end;
+    struct_block blocks[CFG_MAX_BLOCKS];
+    int nb_blocks;
+    int order[CFG_MAX_BLOCKS];
+    int nb_reachable;
+} struct_cfg;
+
+/**
+ * @brief Structure for a natural loop
+ *
+ * A natural loop is defined by a back edge, an edge whose target
+ * dominates its source. The target is the header of the loop. Loops
+ * sharing the same header are merged.
+ *
+ * @param header the block of the header of the loop
+ * @param body true for the blocks in the loop, header included
+ * @param nb_blocks the number of blocks in the loop
+ */
+typedef struct {
+    int header;
+    bool body[CFG_MAX_BLOCKS];
+    int nb_blocks;
+} struct_loop;
+
+/**
+ * @brief Get the instructions range of a function
+ *
+ * @param function the index of the function in the functions table
+ * @param start the index of the first instruction of the function
+ * @param end the index after the last instruction of the function
+ */
+void cfg_get_function_range(int function, int* start, int* end);
+
+/**
+ * @brief Build the control flow graph of a range of instructions
+ *
+ * It splits the instructions into basic blocks, links them and computes
+ * the reverse postorder and the dominators of the blocks.
+ *
+ * @param cfg the control flow graph to build
+ * @param start the index of the first instruction
+ * @param end the index after the last instruction
+ */
+void cfg_build(struct_cfg* cfg, int start, int end);
+
+/**
+ * @brief Get the block of an instruction
+ *
+ * @param cfg the control flow graph
+ * @param index the index of the instruction
+ * @return int the block of the instruction, -1 if outside the graph
+ */
+int cfg_block_of(struct_cfg* cfg, int index);
+
+/**
+ * @brief Check if a block dominates another one
+ *
+ * A block dominates another one if every path from the entry to the
+ * other block goes through it. A block dominates itself.
+ *
+ * @param cfg the control flow graph
+ * @param a the dominating block
+ * @param b the dominated block
+ * @return true if a dominates b
+ */
+bool cfg_dominates(struct_cfg* cfg, int a, int b);
+
+/**
+ * @brief Find the natural loops of the control flow graph
+ *
+ * The loops are sorted by size, so that inner loops come first.
+ *
+ * @param cfg the control flow graph
+ * @param loops the array of loops to fill
+ * @return int the number of loops found
+ */
+int cfg_find_loops(struct_cfg* cfg, struct_loop* loops);
+
+/**
+ * @brief Apply the effects of an instruction to the live slots, backwards
+ *
+ * The slots written by the instruction are no longer live before it,
+ * the slots it reads are.
+ *
+ * @param index the index of the instruction
+ * @param live the live slots after the instruction, updated
+ */
+void cfg_transfer(int index, bool* live);
+
+#endif // CFG_H
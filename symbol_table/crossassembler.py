@@ -1,4 +1,5 @@
-from typing import List, Tuple, Dict
+import sys
+from typing import List, Tuple, Dict, Optional
 
 # Define the instruction set
 opCodeMap = {
@@ -19,16 +20,34 @@ opCodeMap = {
     "JMP": 14,
     "JMF": 15,
     "PRI": 16,
-    "PUSH": 17,
-    "POP": 18,
-    "CALL": 19,
-    "RET": 20,
+    "ENTER": 19,
+    "LEAVE": 20,
     "AFC": 21,
     "LOAD": 22,
     "STORE": 23,
     "COP" : 24,
+    "SHL": 25,
+    "SHR": 26,
+    "BAND": 27,
 }
 
+# An operand that does not fit in its byte, negative or above 255, is moved
+# to an extension word following the instruction, a 32-bit two's complement
+# value. The high bits of the opcode byte tell which operands are extended,
+# the extension words come in the order of the operands.
+extensionFlags = {1: 0x80, 2: 0x40, 3: 0x20}
+
+# The pipeline of the processor, see simulator.h: registers are read in the
+# second stage and written in the last one, so a result can be read
+# pipelineDepth - 2 instructions after the instruction computing it
+pipelineDepth = 5
+
+# The latencies of the results that differ from the one of the pipeline, by opcode
+latencies: Dict[str, int] = {}
+
+# The instructions computing a register from two registers
+aluOps = ["ADD", "SOU", "MUL", "DIV", "EQU", "NEQ", "LT", "LE", "GT", "GE", "AND", "OR", "SHL", "SHR", "BAND"]
+
 def print_header() -> None:
     """
     Print the header of the program
@@ -53,18 +72,135 @@ def read_asm(filename: str) -> List[Tuple[str, int, int, int]]:
     asm = [tuple([str(l[0])] + [int(x) for x in l[1:]]) for l in asm_clean]
     return asm # type: ignore
 
-def initialize_registers(nb_reg: int) -> Dict[int, List[int]]:
+def read_labels(filename: str) -> List[Tuple[int, str]]:
+    """
+    Read the labels of the functions from a file.
+
+    :param filename: The name of the file to read
+    :return: The index of the first instruction and the name of each function
+    """
+    labels = []
+    num = 0
+    for l in open(filename, "r").readlines():
+        e = l.split()
+        if not e or e[0].startswith("#"):
+            continue
+        if e[0].startswith("."):
+            labels.append((num, e[0][1:].rstrip(":")))
+        else:
+            num += 1
+    return labels
+
+def find_leaders(asm: List[Tuple[str, int, int, int]]) -> set:
+    """
+    Find the instructions starting a basic block.
+
+    The registers are not kept across these instructions: they are jumped
+    to, or follow a jump, a call or a return.
+
+    :param asm: The assembly code
+    :return: The indexes of the instructions starting a basic block
+    """
+    leaders = {0}
+    for num, line in enumerate(asm):
+        if line[0] in ["JMP", "ENTER"]:
+            leaders.add(int(line[1]))
+        elif line[0] == "JMF":
+            leaders.add(int(line[2]))
+        if line[0] in ["JMP", "JMF", "ENTER", "LEAVE"]:
+            leaders.add(num + 1)
+    return leaders
+
+def slot_uses(line: Tuple[str, int, int, int], max_slot: int) -> set:
+    """
+    Get the memory slots read by an assembly instruction.
+
+    An ENTER may read every slot above its new frame, the parameters of the
+    callee, and a LEAVE reads the return value in slot 0.
+
+    :param line: The assembly instruction
+    :param max_slot: The largest slot of the program
+    :return: The slots read
+    """
+    if line[0] in aluOps:
+        return {line[2], line[3]}
+    elif line[0] == "COP":
+        return {line[2]}
+    elif line[0] in ["NOT", "PRI", "JMF"]:
+        return {line[1]}
+    elif line[0] == "ENTER":
+        return set(range(line[2] + 1, max_slot + 1))
+    elif line[0] == "LEAVE":
+        return {0}
+    return set()
+
+def slot_defs(line: Tuple[str, int, int, int]) -> set:
+    """
+    Get the memory slots always written by an assembly instruction.
+
+    :param line: The assembly instruction
+    :return: The slots written
+    """
+    if line[0] in aluOps or line[0] in ["AFC", "COP", "NOT"]:
+        return {line[1]}
+    return set()
+
+def compute_liveness(asm: List[Tuple[str, int, int, int]]) -> Tuple[List[set], List[set]]:
+    """
+    Compute the memory slots live before and after each assembly instruction.
+
+    A slot is live if its value may be read later before being written.
+    The analysis stays in each function: a call goes on to the next
+    instruction and a return ends the function.
+
+    :param asm: The assembly code
+    :return: The live slots before and after each instruction
     """
-    Initialize the registers with -1 and 0 values.
+    max_slot = 0
+    for line in asm:
+        slots = slot_defs(line) | (slot_uses(line, 0) if line[0] != "ENTER" else {line[2]})
+        max_slot = max([max_slot] + list(slots))
 
-    For each register, we store the address and the date of the last access.
+    succs = []
+    for num, line in enumerate(asm):
+        if line[0] == "JMP":
+            succs.append([line[1]])
+        elif line[0] == "JMF":
+            succs.append([num + 1, line[2]])
+        elif line[0] == "LEAVE":
+            succs.append([])
+        else:
+            succs.append([num + 1])
+        succs[-1] = [x for x in succs[-1] if x < len(asm)]
+
+    live_in = [set() for _ in asm]
+    live_out = [set() for _ in asm]
+    changed = True
+    while changed:
+        changed = False
+        for num in reversed(range(len(asm))):
+            out = set().union(*[live_in[x] for x in succs[num]])
+            inn = slot_uses(asm[num], max_slot) | (out - slot_defs(asm[num]))
+            if out != live_out[num] or inn != live_in[num]:
+                live_out[num] = out
+                live_in[num] = inn
+                changed = True
+    return live_in, live_out
+
+def initialize_registers(nb_reg: int) -> Dict[int, List]:
+    """
+    Initialize the registers, empty.
+
+    For each register, we store the addresses whose value it holds, the
+    date of the last access, and the addresses whose value it holds but
+    the memory does not yet (dirty).
 
     :param nb_reg: The number of registers to initialize
     """
-    addr_in_register = {i: [-1, 0] for i in range(nb_reg)}
+    addr_in_register = {i: [[], 0, []] for i in range(nb_reg)}
     return addr_in_register
 
-def locate_register(addr: int, addr_in_register: Dict[int, List[int]], nb_reg: int) -> int:
+def locate_register(addr: int, addr_in_register: Dict[int, List], nb_reg: int) -> int:
     """
     Find the register that contains the address.
     
@@ -76,23 +212,75 @@ def locate_register(addr: int, addr_in_register: Dict[int, List[int]], nb_reg: i
     :return: The register that contains the address, or -1 if the address is not in a register
     """
     for i in range(1, nb_reg):
-        if addr_in_register[i][0] == int(addr):
+        if int(addr) in addr_in_register[i][0]:
             return i
     return -1
 
-def find_oldest_register(addr_in_register: Dict[int, List[int]], nb_reg: int) -> int:
+def emit_instruction(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int],
+                     instr: Tuple[str, int, int, int], num: int) -> None:
+    """
+    Add a generated instruction.
+
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
+    :param instr: The new instruction
+    :param num: The number of the assembly instruction it comes from
+    """
+    addr_r_to_addr_m[len(lines_r)] = num
+    lines_r.append(instr)
+
+def spill_register(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int],
+                   addr_in_register: Dict[int, List], reg: int, live: set, num: int) -> None:
+    """
+    Store the dirty addresses of a register that are live.
+
+    The dead ones stay dirty: their value is never read again.
+
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
+    :param addr_in_register: The dictionary with the addresses in the registers
+    :param reg: The register to store
+    :param live: The live addresses
+    :param num: The number of the assembly instruction the stores go with
+    """
+    for addr in [a for a in addr_in_register[reg][2] if a in live]:
+        emit_instruction(lines_r, addr_r_to_addr_m, storereg(reg, addr), num)
+        addr_in_register[reg][2].remove(addr)
+
+def spill_registers(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int],
+                    addr_in_register: Dict[int, List], nb_reg: int, live: set, num: int) -> None:
+    """
+    Store the dirty addresses of all the registers that are live.
+
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
+    :param addr_in_register: The dictionary with the addresses in the registers
+    :param nb_reg: The number of registers
+    :param live: The live addresses
+    :param num: The number of the assembly instruction the stores go with
+    """
+    for i in range(1, nb_reg):
+        spill_register(lines_r, addr_r_to_addr_m, addr_in_register, i, live, num)
+
+def find_oldest_register(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int],
+                         addr_in_register: Dict[int, List], nb_reg: int, live: set, num: int) -> int:
     """
     Find the oldest register that is not used.
     
-    If all registers are used, return the oldest one.
+    If all registers are used, return the oldest one, after storing its
+    live dirty addresses.
 
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
     :param addr_in_register: The dictionary with the addresses in the registers
     :param nb_reg: The number of registers
+    :param live: The live addresses
+    :param num: The number of the current assembly instruction
     :return: The oldest register that is not used, or the oldest one if all registers are used
     """
     # If there is an empty register, return it
     for j in range(1, nb_reg):
-        if addr_in_register[j][0] == -1:
+        if not addr_in_register[j][0]:
             return j
     
     # Otherwise, find the oldest register
@@ -102,33 +290,70 @@ def find_oldest_register(addr_in_register: Dict[int, List[int]], nb_reg: int) ->
         if addr_in_register[i][1] > date:
             oldest = i
             date = addr_in_register[i][1]
+    spill_register(lines_r, addr_r_to_addr_m, addr_in_register, oldest, live, num)
     invalidate_register(addr_in_register, oldest)
     return oldest
 
-def invalidate_address(addr_in_register: Dict[int, List[int]], addr: int, nb_reg: int) -> None:
+def load_register(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int],
+                  addr_in_register: Dict[int, List], nb_reg: int, addr: int, live: set, num: int) -> int:
     """
-    Unvalidate the address in the registers.
+    Get a register holding the value of an address, loading it if needed.
+
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
+    :param addr_in_register: The dictionary with the addresses in the registers
+    :param nb_reg: The number of registers
+    :param addr: The address
+    :param live: The live addresses
+    :param num: The number of the current assembly instruction
+    :return: The register
+    """
+    reg = locate_register(addr, addr_in_register, nb_reg)
+    if reg == -1:
+        reg = find_oldest_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, loadreg(reg, addr), num)
+        update_register_address(addr_in_register, addr, reg)
+    addr_in_register[reg][1] = 0
+    return reg
+
+def invalidate_address(addr_in_register: Dict[int, List], addr: int, nb_reg: int) -> None:
+    """
+    Unvalidate the address in the registers, its value is overwritten.
 
     :param addr_in_register: The dictionary with the addresses in the registers
     :param addr: The address to unvalidate
     :param nb_reg: The number of registers
     """
     for i in range(1, nb_reg):
-        if addr_in_register[i][0] == int(addr):
-            addr_in_register[i][0] = -1
-            addr_in_register[i][1] = 0
+        if int(addr) in addr_in_register[i][0]:
+            addr_in_register[i][0].remove(int(addr))
+            if int(addr) in addr_in_register[i][2]:
+                addr_in_register[i][2].remove(int(addr))
+            if not addr_in_register[i][0]:
+                addr_in_register[i][1] = 0
+
+def invalidate_registers(addr_in_register: Dict[int, List], nb_reg: int) -> None:
+    """
+    Unvalidate all the registers.
+
+    :param addr_in_register: The dictionary with the addresses in the registers
+    :param nb_reg: The number of registers
+    """
+    for i in range(1, nb_reg):
+        invalidate_register(addr_in_register, i)
 
-def invalidate_register(addr_in_register: Dict[int, List[int]], reg: int) -> None:
+def invalidate_register(addr_in_register: Dict[int, List], reg: int) -> None:
     """
     Unvalidate the register.
 
     :param addr_in_register: The dictionary with the addresses in the registers
     :param reg: The register to unvalidate
     """
-    addr_in_register[reg][0] = -1
+    addr_in_register[reg][0] = []
     addr_in_register[reg][1] = 0
+    addr_in_register[reg][2] = []
 
-def increase_register_dates(addr_in_register: Dict[int, List[int]], nb_reg: int) -> None:
+def increase_register_dates(addr_in_register: Dict[int, List], nb_reg: int) -> None:
     """
     Add one to the date of the registers.
 
@@ -136,42 +361,84 @@ def increase_register_dates(addr_in_register: Dict[int, List[int]], nb_reg: int)
     :param nb_reg: The number of registers
     """
     for i in range(1, nb_reg):
-        if addr_in_register[i][0] != -1:
+        if addr_in_register[i][0]:
             addr_in_register[i][1] += 1
 
-def update_register_address(addr_in_register: Dict[int, List[int]], addr: int, reg: int) -> None:
+def update_register_address(addr_in_register: Dict[int, List], addr: int, reg: int) -> None:
     """
     Update the address in the register with the given address.
 
+    The register holds the value of the memory at this address only.
+
     :param addr_in_register: The dictionary with the addresses in the registers
     :param addr: The address to update
+    :param reg: The register
     """
-    addr_in_register[reg][0] = int(addr)
+    addr_in_register[reg][0] = [int(addr)]
     addr_in_register[reg][1] = 0
+    addr_in_register[reg][2] = []
+
+def write_register_address(addr_in_register: Dict[int, List], addr: int, reg: int, nb_reg: int, alias: bool) -> None:
+    """
+    Give a register the new value of an address, without storing it.
+
+    :param addr_in_register: The dictionary with the addresses in the registers
+    :param addr: The address written
+    :param reg: The register holding the new value
+    :param nb_reg: The number of registers
+    :param alias: True to keep the other addresses of the register, for a copy
+    """
+    invalidate_address(addr_in_register, addr, nb_reg)
+    if not alias:
+        update_register_address(addr_in_register, addr, reg)
+    else:
+        addr_in_register[reg][0].append(int(addr))
+        addr_in_register[reg][1] = 0
+    addr_in_register[reg][2].append(int(addr))
 
-def print_registers(addr_in_register: Dict[int, List[int]], nb_reg: int) -> None:
+def print_registers(addr_in_register: Dict[int, List], nb_reg: int) -> None:
     """
-    Print the addresses in the registers.
+    Print the addresses in the registers, a dirty one followed by a star.
 
     :param addr_in_register: The dictionary with the addresses in the registers
     :param nb_reg: The number of registers
     """
     print("[", end='', flush=True)
     for i in range(1, nb_reg):
-        print(str(addr_in_register[i][0]) + ",", end='', flush=True)
+        addrs = [str(a) + ("*" if a in addr_in_register[i][2] else "") for a in addr_in_register[i][0]]
+        print(("/".join(addrs) if addrs else "-1") + ",", end='', flush=True)
     print("]")
 
 def get_new_address(addr_r_to_addr_m: Dict[int, int], old_addr: int, current_addr_r: int) -> int:
     """
     Get the new address for the given old address.
-    
+
+    This is the first generated instruction of the old one, or of the next
+    one if it did not generate any.
+
     :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
     :param old_addr: The old address to find
+    :param current_addr_r: The number of generated instructions
+    :return: The new address, current_addr_r if the old address is past the end
     """
-    for i in range(1, current_addr_r):
-        if addr_r_to_addr_m[i] == old_addr:
+    for i in range(0, current_addr_r):
+        if addr_r_to_addr_m[i] >= old_addr:
             return i
-    return -1
+    return current_addr_r
+
+def remap_targets(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int], current_addr_r: int) -> None:
+    """
+    Replace the targets of the jumps and calls by their new addresses.
+
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
+    :param current_addr_r: The number of generated instructions
+    """
+    for i, instr in enumerate(lines_r):
+        if instr[0] in ["JMP", "ENTER"]:
+            lines_r[i] = (instr[0], get_new_address(addr_r_to_addr_m, instr[1], current_addr_r), instr[2], instr[3])
+        elif instr[0] == "JMF":
+            lines_r[i] = (instr[0], instr[1], get_new_address(addr_r_to_addr_m, instr[2], current_addr_r), instr[3])
 
 def loadreg(reg: int, addr: int) -> Tuple[str, int, int, int]:
     """
@@ -193,127 +460,94 @@ def storereg(reg: int, addr: int) -> Tuple[str, int, int, int]:
 
 
 def handle_instruction(
-    lines_r: List[Tuple[str, int, int, int]], line: Tuple[str, int, int, int], num: int, addr_in_register: Dict[int, List[int]], 
-    addr_r_to_addr_m: Dict[int, int], current_addr_r: int, nb_reg: int
-) -> int:
+    lines_r: List[Tuple[str, int, int, int]], line: Tuple[str, int, int, int], num: int, addr_in_register: Dict[int, List],
+    addr_r_to_addr_m: Dict[int, int], nb_reg: int, live_in: set, live_out: set
+) -> None:
     """
     Handle the instruction line.
 
-    Registers are managed using a Least Recently Used (LRU) policy.
+    Registers are managed using a Least Recently Used (LRU) policy. The
+    instructions computing a register are OP dest src1 src2, so that
+    SOU r3 r1 r2 is r3 = r1 - r2.
+
+    The registers are a write-back cache of the memory: a result stays in
+    its register, dirty, and is only stored when its register is reused or
+    at the end of the block, if its address is still live. So a temporary
+    read only from its register is never stored. A copy makes the register
+    of the source hold the destination too, without loading it again.
 
     :param lines_r: The list of instructions
     :param line: The current instruction line
     :param num: The current instruction number
     :param addr_in_register: The dictionary with the addresses in the registers
     :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
-    :param current_addr_r: The current address in the registers
     :param nb_reg: The number of registers
-    :return: The new current address in the registers
+    :param live_in: The live addresses before the instruction
+    :param live_out: The live addresses after the instruction
     """
+    live = live_in | live_out
 
-    
-    if line[0] in ["ADD", "SOU", "MUL", "DIV"]:
-        r1 = locate_register(int(line[1]), addr_in_register, nb_reg)
-        r2 = locate_register(int(line[2]), addr_in_register, nb_reg)
-
+    if line[0] in aluOps:
         # If the address is not in a register, load it
-        if r1 == -1:
-            r1 = find_oldest_register(addr_in_register, nb_reg)
-            lines_r.append(loadreg(r1, int(line[2])))
-            addr_r_to_addr_m[current_addr_r] = num
-            current_addr_r += 1
-
-        if r2 == -1:
-            r2 = find_oldest_register(addr_in_register, nb_reg)
-            lines_r.append(loadreg(r2, int(line[3])))
-            addr_r_to_addr_m[current_addr_r] = num
-            current_addr_r += 1
-
-        # Find the oldest register to store the result
-        r3 = find_oldest_register(addr_in_register, nb_reg)
-
-        # Update the registers with the new addresses
-        update_register_address(addr_in_register, int(line[2]), r1)
-        update_register_address(addr_in_register, int(line[3]), r2)
-
-        # Add the instruction to the list
-        lines_r.append((line[0], r3, r2, r1))
-        lines_r.append(storereg(r3, int(line[1])))
-
-        # Update the address in the registers
-        addr_r_to_addr_m[current_addr_r] = num
-        addr_r_to_addr_m[current_addr_r+1] = num
-        current_addr_r += 2
+        r1 = load_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, int(line[2]), live, num)
+        r2 = load_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, int(line[3]), live, num)
 
-        invalidate_address(addr_in_register, int(line[1]), nb_reg)
-        update_register_address(addr_in_register, int(line[1]), r3)
+        # Find the oldest register to hold the result
+        r3 = find_oldest_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], r3, r1, r2), num)
+        write_register_address(addr_in_register, int(line[1]), r3, nb_reg, False)
 
-    elif line[0] == "COP":
-        r1 = locate_register(int(line[2]), addr_in_register, nb_reg)
-        if r1 == -1:
-            r1 = find_oldest_register(addr_in_register, nb_reg)
-            lines_r.append(loadreg(r1, int(line[2])))
-            addr_r_to_addr_m[current_addr_r] = num
-            current_addr_r += 1
-
-        lines_r.append(storereg(r1, int(line[1])))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
+    elif line[0] == "NOT":
+        r1 = load_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, int(line[1]), live, num)
+        r2 = find_oldest_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], r2, r1, 0), num)
+        write_register_address(addr_in_register, int(line[1]), r2, nb_reg, False)
 
-        invalidate_address(addr_in_register, int(line[1]), nb_reg)
-        update_register_address(addr_in_register, int(line[1]), r1)
+    elif line[0] == "COP":
+        r1 = load_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, int(line[2]), live, num)
+        if int(line[1]) != int(line[2]):
+            write_register_address(addr_in_register, int(line[1]), r1, nb_reg, True)
 
     elif line[0] == "AFC":
-        r1 = find_oldest_register(addr_in_register, nb_reg)
-        lines_r.append((line[0], r1, int(line[2]), 0))
-        lines_r.append(storereg(r1, int(line[1])))
-
-        addr_r_to_addr_m[current_addr_r] = num
-        addr_r_to_addr_m[current_addr_r+1] = num
-        current_addr_r += 2
-
-        invalidate_address(addr_in_register, int(line[1]), nb_reg)
-        update_register_address(addr_in_register, int(line[1]), r1)
+        r1 = find_oldest_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], r1, int(line[2]), 0), num)
+        write_register_address(addr_in_register, int(line[1]), r1, nb_reg, False)
 
     elif line[0] == "LOAD":
-        invalidate_register(addr_in_register, int(line[2]))
-        lines_r.append((line[0], int(line[1]), int(line[2]), 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
-        update_register_address(addr_in_register, int(line[3]), int(line[2]))
+        spill_register(lines_r, addr_r_to_addr_m, addr_in_register, int(line[1]), live, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], int(line[1]), int(line[2]), 0), num)
+        update_register_address(addr_in_register, int(line[2]), int(line[1]))
 
     elif line[0] == "STORE":
-        invalidate_address(addr_in_register, int(line[3]), nb_reg)
-        lines_r.append((line[0], int(line[1]), int(line[2]), 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
+        invalidate_address(addr_in_register, int(line[1]), nb_reg)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], int(line[1]), int(line[2]), 0), num)
 
     elif line[0] == "NOP":
-        lines_r.append((line[0], 0, 0, 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], 0, 0, 0), num)
 
     elif line[0] == "JMP":
-        lines_r.append((line[0], int(line[1]), 0, 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
+        spill_registers(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live_out, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], int(line[1]), 0, 0), num)
+        invalidate_registers(addr_in_register, nb_reg)
 
     elif line[0] == "JMF":
-        lines_r.append(loadreg(1, int(line[2])))
-        lines_r.append((line[0], 1, int(line[2]), 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        addr_r_to_addr_m[current_addr_r+1] = num
-        current_addr_r += 2
+        r1 = load_register(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, int(line[1]), live, num)
+        spill_registers(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live_out, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], r1, int(line[2]), 0), num)
+        invalidate_registers(addr_in_register, nb_reg)
 
     elif line[0] == "PRI":
-        lines_r.append((line[0], int(line[1]), 0, 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
+        # The value is printed from the memory
+        r1 = locate_register(int(line[1]), addr_in_register, nb_reg)
+        if r1 != -1:
+            spill_register(lines_r, addr_r_to_addr_m, addr_in_register, r1, {int(line[1])}, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], int(line[1]), 0, 0), num)
 
-    elif line[0] == "RET":
-        lines_r.append((line[0], 0, 0, 0))
-        addr_r_to_addr_m[current_addr_r] = num
-        current_addr_r += 1
+    elif line[0] in ["ENTER", "LEAVE"]:
+        # The callee reads its parameters and the caller the return value from the memory
+        spill_registers(lines_r, addr_r_to_addr_m, addr_in_register, nb_reg, live_in, num)
+        emit_instruction(lines_r, addr_r_to_addr_m, (line[0], int(line[1]), int(line[2]), 0) if line[0] == "ENTER" else (line[0], 0, 0, 0), num)
+        invalidate_registers(addr_in_register, nb_reg)
 
     else:
         print(f"[!] Unrecognized command: {line[0]}")
@@ -322,35 +556,307 @@ def handle_instruction(
     print(f"[+] Processed: {line}. Registers: ", end='', flush=True)
     print_registers(addr_in_register, nb_reg)
 
-    return current_addr_r
+def register_reads(instr: Tuple[str, int, int, int]) -> List[int]:
+    """
+    Get the registers read by a generated instruction.
+
+    :param instr: The instruction
+    :return: The registers read
+    """
+    if instr[0] in aluOps:
+        return [instr[2], instr[3]]
+    elif instr[0] in ["NOT", "COP", "STORE"]:
+        return [instr[2]]
+    elif instr[0] == "JMF":
+        return [instr[1]]
+    return []
+
+def register_write(instr: Tuple[str, int, int, int]) -> int:
+    """
+    Get the register written by a generated instruction.
+
+    :param instr: The instruction
+    :return: The register written, or -1 if none
+    """
+    if instr[0] in aluOps or instr[0] in ["NOT", "COP", "AFC", "LOAD"]:
+        return instr[1]
+    return -1
+
+def memory_access(instr: Tuple[str, int, int, int]) -> Optional[Tuple[int, bool]]:
+    """
+    Get the memory access of a generated instruction.
+
+    :param instr: The instruction
+    :return: The address and True for a write, or None if the instruction does not access the memory
+    """
+    if instr[0] == "LOAD":
+        return (instr[2], False)
+    elif instr[0] == "STORE":
+        return (instr[1], True)
+    elif instr[0] == "PRI":
+        return (instr[1], False)
+    return None
+
+def build_dependencies(block: List[Tuple[str, int, int, int]], depth: int, lat: Dict[str, int]) -> List[List[Tuple[int, int]]]:
+    """
+    Build the dependencies between the instructions of a basic block.
+
+    An instruction reading a register waits for the latency of the
+    instruction writing it. The other dependencies, on a register or on a
+    memory address, only keep the order, as the processor reads the
+    registers and accesses the memory in order. The PRIs keep their order,
+    and the jump, call or return ending the block stays last.
+
+    :param block: The instructions of the block
+    :param depth: The number of stages of the pipeline
+    :param lat: The latencies that differ from the one of the pipeline, by opcode
+    :return: The instructions each instruction depends on, with the latency
+    """
+    preds = [[] for _ in block]
+    last_write = {}
+    reads_since = {}
+    mem_write = {}
+    mem_reads = {}
+    last_print = -1
+    for i, instr in enumerate(block):
+        for r in register_reads(instr):
+            if r in last_write:
+                p = last_write[r]
+                preds[i].append((p, lat.get(block[p][0], depth - 2)))
+            reads_since.setdefault(r, []).append(i)
+        w = register_write(instr)
+        if w != -1:
+            preds[i] += [(p, 1) for p in reads_since.get(w, []) if p != i]
+            if w in last_write:
+                preds[i].append((last_write[w], 1))
+            last_write[w] = i
+            reads_since[w] = []
+
+        access = memory_access(instr)
+        if access is not None:
+            addr, write = access
+            if addr in mem_write:
+                preds[i].append((mem_write[addr], 1))
+            if write:
+                preds[i] += [(p, 1) for p in mem_reads.get(addr, [])]
+                mem_write[addr] = i
+                mem_reads[addr] = []
+            else:
+                mem_reads.setdefault(addr, []).append(i)
+        if instr[0] == "PRI":
+            if last_print != -1:
+                preds[i].append((last_print, 1))
+            last_print = i
+        if instr[0] in ["JMP", "JMF", "ENTER", "LEAVE"]:
+            preds[i] += [(p, 1) for p in range(i)]
+    return preds
+
+def issue_times(order: List[int], preds: List[List[Tuple[int, int]]]) -> List[Optional[int]]:
+    """
+    Issue the instructions of a block in the given order, as early as their dependencies allow.
+
+    :param order: The order of the instructions
+    :param preds: The dependencies of the instructions
+    :return: The instructions by issue slot, None for a slot left empty
+    """
+    time = {}
+    slots: List[Optional[int]] = []
+    for v in order:
+        earliest = max([time[p] + l for p, l in preds[v]], default=0)
+        while len(slots) < earliest:
+            slots.append(None)
+        time[v] = len(slots)
+        slots.append(v)
+    return slots
+
+def list_schedule(preds: List[List[Tuple[int, int]]]) -> List[int]:
+    """
+    Order the instructions of a block with a list scheduler.
+
+    At each slot, the ready instruction with the longest path to the end
+    of the block is issued first, the earliest one on a tie.
+
+    :param preds: The dependencies of the instructions
+    :return: The new order of the instructions
+    """
+    n = len(preds)
+    succs = [[] for _ in range(n)]
+    for v in range(n):
+        for p, l in preds[v]:
+            succs[p].append((v, l))
+    height = [0] * n
+    for v in reversed(range(n)):
+        height[v] = max([l + height[s] for s, l in succs[v]], default=0)
+
+    time = {}
+    order = []
+    slot = 0
+    while len(order) < n:
+        ready = [v for v in range(n) if v not in time and all(p in time and time[p] + l <= slot for p, l in preds[v])]
+        if ready:
+            v = max(ready, key=lambda v: (height[v], -v))
+            time[v] = slot
+            order.append(v)
+        slot += 1
+    return order
+
+def schedule_blocks(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int], current_addr_r: int,
+                    leaders: set, depth: int, lat: Dict[str, int], interlocked: bool) -> Tuple[List[Tuple[str, int, int, int]], Dict[int, int], int]:
+    """
+    Reorder the instructions of each basic block to hide the latencies of the registers.
+
+    The registers are reloaded at the start of each block, see
+    find_leaders, so no latency crosses a block. Unless the processor
+    stalls on its own, NOPs fill the slots where no instruction is ready.
+    The emission order is kept when it needs fewer NOPs.
+
+    :param lines_r: The list of instructions
+    :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
+    :param current_addr_r: The number of generated instructions
+    :param leaders: The indexes of the assembly instructions starting a basic block
+    :param depth: The number of stages of the pipeline
+    :param lat: The latencies that differ from the one of the pipeline, by opcode
+    :param interlocked: True if the processor stalls on a hazard, then no NOP is inserted
+    :return: The new instructions, their mapping and their number
+    """
+    starts = {get_new_address(addr_r_to_addr_m, num, current_addr_r) for num in leaders}
+    for i, instr in enumerate(lines_r):
+        if instr[0] in ["JMP", "JMF", "ENTER", "LEAVE"]:
+            starts.add(i + 1)
+    starts = sorted(x for x in starts | {0} if x < current_addr_r) + [current_addr_r]
+
+    new_lines = []
+    new_map = {}
+    nb_blocks = nb_nops = nb_nops_before = 0
+    for start, end in zip(starts, starts[1:]):
+        block = lines_r[start:end]
+        preds = build_dependencies(block, depth, lat)
+        before = issue_times(list(range(len(block))), preds)
+        after = issue_times(list_schedule(preds), preds)
+        slots = after if len(after) < len(before) else before
+        nb_blocks += 1
+        nb_nops_before += len(before) - len(block)
+        nb_nops += len(slots) - len(block)
+
+        # A NOP goes with the assembly instruction of the next instruction
+        for k, v in enumerate(slots):
+            if v is None and interlocked:
+                continue
+            following = next(x for x in slots[k:] if x is not None)
+            new_map[len(new_lines)] = addr_r_to_addr_m[start + following]
+            new_lines.append(("NOP", 0, 0, 0) if v is None else block[v])
+
+    print(f"[+] Scheduled {nb_blocks} block(s): {nb_nops} stall slot(s) left, {nb_nops_before} in the emission order, "
+          + ("no NOP inserted" if interlocked else f"{nb_nops} NOP(s) inserted"))
+    return new_lines, new_map, len(new_lines)
+
+def fits_in_byte(value: int) -> bool:
+    """
+    Check if an operand fits in its byte of an instruction word.
+
+    :param value: The operand
+    :return: True if the operand needs no extension word
+    """
+    return 0 <= value <= 255
+
+def resolve_targets(instr: Tuple[str, int, int, int], word_addresses: List[int]) -> Tuple[str, int, int, int]:
+    """
+    Replace the target of a jump or a call, an instruction index, by its word address.
+
+    :param instr: The instruction
+    :param word_addresses: The word address of each instruction, then of the end of the ROM
+    :return: The instruction with its target as a word address
+    """
+    if instr[0] in ["JMP", "ENTER"]:
+        return (instr[0], word_addresses[instr[1]], instr[2], instr[3])
+    elif instr[0] == "JMF":
+        return (instr[0], instr[1], word_addresses[instr[2]], instr[3])
+    return instr
+
+def assign_word_addresses(lines_r: List[Tuple[str, int, int, int]]) -> List[int]:
+    """
+    Compute the word address of each instruction.
+
+    An instruction takes one word, plus one per extended operand. Its size
+    depends on its target for a jump, which depends on the sizes before
+    the target, so the sizes are computed again until they are stable.
+    They only grow, so this ends.
+
+    :param lines_r: The list of instructions, with their targets as instruction indexes
+    :return: The word address of each instruction, then of the end of the ROM
+    """
+    sizes = [1] * len(lines_r)
+    while True:
+        word_addresses = [0]
+        for size in sizes:
+            word_addresses.append(word_addresses[-1] + size)
+        new_sizes = [1 + sum(not fits_in_byte(v) for v in resolve_targets(instr, word_addresses)[1:]) for instr in lines_r]
+        if new_sizes == sizes:
+            return word_addresses
+        sizes = new_sizes
+
+def encode(instr: Tuple[str, int, int, int]) -> List[int]:
+    """
+    Encode an instruction into its words.
+
+    :param instr: The instruction, with its target as a word address
+    :return: The instruction word, then its extension words
+    """
+    opcode = opCodeMap[instr[0]]
+    fields = []
+    extensions = []
+    for k in range(1, 4):
+        if fits_in_byte(instr[k]):
+            fields.append(instr[k])
+        else:
+            opcode |= extensionFlags[k]
+            fields.append(0)
+            extensions.append(instr[k] & 0xffffffff)
+    return [(opcode << 24) | (fields[0] << 16) | (fields[1] << 8) | fields[2]] + extensions
 
 def print_final_instructions(lines_r: List[Tuple[str, int, int, int]], addr_r_to_addr_m: Dict[int, int],
-                             current_addr_r: int, target_file: str|None) -> None:
+                             current_addr_r: int, target_file: str|None, labels: List[Tuple[int, str]] = []) -> None:
     """
     Print the final instructions.
 
+    The targets of the jumps and calls become word addresses, see
+    assign_word_addresses. The word address of each function is written
+    to target_file.map, one "address name" line per function, for the
+    simulator.
+
     :param lines_r: The list of instructions
     :param addr_r_to_addr_m: The dictionary with the mapping between the registers and the memory addresses
     :param current_addr_r: The current address in the registers
+    :param target_file: The file to write the binary code to (optional)
+    :param labels: The index of the first instruction and the name of each function
     """
     
     print("[+] New generated instructions:")
     for i in range(1, current_addr_r):
         print(f"[{addr_r_to_addr_m[i]}] : {lines_r[i]}")
 
+    word_addresses = assign_word_addresses(lines_r)
+    words = [w for instr in lines_r for w in encode(resolve_targets(instr, word_addresses))]
+    print(f"[+] ROM: {current_addr_r} instruction(s) in {len(words)} word(s), {len(words) - current_addr_r} extension word(s)")
+
     # Write the assembly code to a file
     if target_file != None:
         f = open(target_file, "w")
         f.write("constant ROM : memory := (\n")
-        for instr in lines_r:
-            f.write("(x\"%02x%02x%02x%02x\"),\n" % (opCodeMap[instr[0]], instr[1], instr[2], instr[3])) 
+        for word in words:
+            f.write("(x\"%08x\"),\n" % word)
         f.write("others => (x\"00000000\"));\n")
         f.close()
 
+        f = open(target_file + ".map", "w")
+        for num, name in labels:
+            f.write("%d %s\n" % (word_addresses[get_new_address(addr_r_to_addr_m, num, current_addr_r)], name))
+        f.close()
+
 
 
 # Main function to perform cross-assembly
-def cross_assemble(source_file: str, target_file: str):
+def cross_assemble(source_file: str, target_file: str, schedule: bool = True, interlocked: bool = False):
     """
     Perform the cross-assembly.
 
@@ -360,26 +866,69 @@ def cross_assemble(source_file: str, target_file: str):
     
     :param source_file: The source file with the assembly code
     :param target_file: The target file to write the binary code (optional)
-    
+    :param schedule: True to reorder the instructions of the basic blocks, see schedule_blocks
+    :param interlocked: True if the processor stalls on a hazard, False to insert NOPs instead
     """
     print_header()
 
     # Set up the registers and the memory
     asm = read_asm(source_file)
+    leaders = find_leaders(asm)
     nb_reg = 8
     addresses_in_register = initialize_registers(nb_reg)
+    live_in, live_out = compute_liveness(asm)
     lines_r = []
     addr_r_to_addr_m = {}
-    current_addr_r = 0
 
     # Process the instructions
     for num, line in enumerate(asm):
-        current_addr_r = handle_instruction(lines_r, line, num, addresses_in_register, addr_r_to_addr_m, current_addr_r, nb_reg)
+        # Another path may reach a leader with other values in the registers
+        if num in leaders:
+            spill_registers(lines_r, addr_r_to_addr_m, addresses_in_register, nb_reg, live_in[num], num - 1)
+            invalidate_registers(addresses_in_register, nb_reg)
+        handle_instruction(lines_r, line, num, addresses_in_register, addr_r_to_addr_m, nb_reg, live_in[num], live_out[num])
+    current_addr_r = len(lines_r)
+    print(f"[+] Memory accesses: {sum(i[0] == 'LOAD' for i in lines_r)} LOAD(s), {sum(i[0] == 'STORE' for i in lines_r)} STORE(s)")
+
+    if schedule:
+        lines_r, addr_r_to_addr_m, current_addr_r = schedule_blocks(
+            lines_r, addr_r_to_addr_m, current_addr_r, leaders, pipelineDepth, latencies, interlocked)
 
     # Print the final instructions to the console and write them to a file
-    print_final_instructions(lines_r, addr_r_to_addr_m, current_addr_r, target_file)
+    remap_targets(lines_r, addr_r_to_addr_m, current_addr_r)
+    print_final_instructions(lines_r, addr_r_to_addr_m, current_addr_r, target_file, read_labels(source_file))
+
+def print_usage() -> None:
+    """
+    Print the usage of the cross assembler.
+    """
+    print("usage: crossassembler.py [--no-schedule] [--interlocked] [--depth=n] [--latency=OP:n,...]")
+    print("  --no-schedule      keep the instructions in the order they are generated")
+    print("  --interlocked      the processor stalls on a hazard, do not insert NOPs")
+    print(f"  --depth=n          the number of stages of the pipeline, {pipelineDepth} by default")
+    print("  --latency=OP:n     the number of instructions before the result of OP can be read")
 
 source_file = "asm.txt"
 target_file = "asm.bin"
-cross_assemble(source_file, target_file)
+schedule = True
+interlocked = False
+for arg in sys.argv[1:]:
+    if arg == "--no-schedule":
+        schedule = False
+    elif arg == "--interlocked":
+        interlocked = True
+    elif arg.startswith("--depth=") and arg[8:].isdigit() and int(arg[8:]) >= 2:
+        pipelineDepth = int(arg[8:])
+    elif arg.startswith("--latency="):
+        try:
+            for item in arg[10:].split(","):
+                op, n = item.split(":")
+                latencies[op.upper()] = int(n)
+        except ValueError:
+            print_usage()
+            sys.exit(1)
+    else:
+        print_usage()
+        sys.exit(1)
+cross_assemble(source_file, target_file, schedule, interlocked)
 
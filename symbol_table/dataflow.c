@@ -0,0 +1,257 @@
+/**
+ * @file dataflow.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the dataflow analyses
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "dataflow.h"
+#include <string.h> // memset, memcpy
+
+/* Predecessors of the blocks, those of block b from pred_start[b] to pred_start[b+1] */
+static int pred_start[CFG_MAX_BLOCKS + 1];
+static int preds[2 * CFG_MAX_BLOCKS];
+
+/* Build the predecessors of the blocks from their successors */
+static void df_build_preds(struct_cfg* cfg) {
+    memset(pred_start, 0, sizeof(int) * (cfg->nb_blocks + 1));
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        for(int s = 0; s < cfg->blocks[b].nb_succ; s++) {
+            pred_start[cfg->blocks[b].succ[s] + 1]++;
+        }
+    }
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        pred_start[b + 1] += pred_start[b];
+    }
+    static int next[CFG_MAX_BLOCKS];
+    memcpy(next, pred_start, sizeof(int) * cfg->nb_blocks);
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        for(int s = 0; s < cfg->blocks[b].nb_succ; s++) {
+            preds[next[cfg->blocks[b].succ[s]]++] = b;
+        }
+    }
+}
+
+/* Check if a block starts from the empty set */
+static bool df_is_boundary(struct_cfg* cfg, struct_dataflow* df, int b) {
+    return df->forward ? b == 0 : cfg->blocks[b].nb_succ == 0;
+}
+
+/* Meet the sets of the neighbors of a block into its input set */
+static void df_meet(struct_cfg* cfg, struct_dataflow* df, int b, bitset_word* input, int words) {
+    bs_fill(input, 0, words);
+    if(df_is_boundary(cfg, df, b)) {
+        return;
+    }
+    int first = df->forward ? pred_start[b] : 0;
+    int last = df->forward ? pred_start[b+1] : cfg->blocks[b].nb_succ;
+    for(int n = first; n < last; n++) {
+        int neighbor = df->forward ? preds[n] : cfg->blocks[b].succ[n];
+        bitset_word* set = df->forward ? df->out[neighbor] : df->in[neighbor];
+        if(!df->intersection) {
+            bs_union(input, set, words);
+        } else if(n == first) {
+            bs_copy(input, set, words);
+        } else {
+            bs_intersect(input, set, words);
+        }
+    }
+}
+
+/* Solve a dataflow analysis */
+void df_solve(struct_cfg* cfg, struct_dataflow* df) {
+    static int order[CFG_MAX_BLOCKS];
+    static bool queued[CFG_MAX_BLOCKS];
+    int words = BS_WORDS(df->nb_bits);
+    df_build_preds(cfg);
+
+    // Reverse postorder, then the unreachable blocks, backwards for a backward analysis
+    int nb_order = 0;
+    for(int o = 0; o < cfg->nb_reachable; o++) {
+        order[nb_order++] = cfg->order[o];
+    }
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        if(cfg->blocks[b].rpo == -1) {
+            order[nb_order++] = b;
+        }
+    }
+    if(!df->forward) {
+        for(int o = 0; o < nb_order / 2; o++) {
+            int tmp = order[o];
+            order[o] = order[nb_order - 1 - o];
+            order[nb_order - 1 - o] = tmp;
+        }
+    }
+
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        bitset_word* result = df->forward ? df->out[b] : df->in[b];
+        bs_fill(df->forward ? df->in[b] : df->out[b], 0, words);
+        bs_fill(result, 0, words);
+        if(df->intersection && !df_is_boundary(cfg, df, b)) {
+            bs_set_range(result, 0, df->nb_bits);
+        }
+        queued[b] = true;
+    }
+
+    df->nb_visits = 0;
+    bool pending = true;
+    while(pending) {
+        pending = false;
+        for(int o = 0; o < nb_order; o++) {
+            int b = order[o];
+            if(!queued[b]) {
+                continue;
+            }
+            queued[b] = false;
+            df->nb_visits++;
+
+            bitset_word* input = df->forward ? df->in[b] : df->out[b];
+            bitset_word* result = df->forward ? df->out[b] : df->in[b];
+            df_meet(cfg, df, b, input, words);
+            if(!bs_transfer(result, df->gen[b], input, df->kill[b], words)) {
+                continue;
+            }
+
+            // The blocks reading the result are visited again
+            int first = df->forward ? 0 : pred_start[b];
+            int last = df->forward ? cfg->blocks[b].nb_succ : pred_start[b+1];
+            for(int n = first; n < last; n++) {
+                int next = df->forward ? cfg->blocks[b].succ[n] : preds[n];
+                if(!queued[next]) {
+                    queued[next] = true;
+                    pending = true;
+                }
+            }
+        }
+    }
+}
+
+/* Clamp the end of a range of slots to the tracked slots */
+static int df_range_end(int to, int max) {
+    return (to == -1 || to > max) ? max : to;
+}
+
+/* Compute the liveness of the memory slots */
+void df_liveness(struct_cfg* cfg, struct_liveness* liveness) {
+    static struct_dataflow df;
+    int words = BS_WORDS(CFG_MAX_SLOTS);
+    df.forward = false;
+    df.intersection = false;
+    df.nb_bits = CFG_MAX_SLOTS;
+
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        bs_fill(df.gen[b], 0, words);
+        bs_fill(df.kill[b], 0, words);
+        // Backwards, like cfg_transfer
+        for(int i = cfg->blocks[b].end - 1; i >= cfg->blocks[b].start; i--) {
+            struct_effects e = it_get_effects(i);
+            for(int d = 0; d < e.nb_defs; d++) {
+                if(e.defs[d] >= 0 && e.defs[d] < CFG_MAX_SLOTS) {
+                    bs_reset(df.gen[b], e.defs[d]);
+                    bs_set(df.kill[b], e.defs[d]);
+                }
+            }
+            for(int u = 0; u < e.nb_uses; u++) {
+                if(e.uses[u] >= 0 && e.uses[u] < CFG_MAX_SLOTS) {
+                    bs_set(df.gen[b], e.uses[u]);
+                }
+            }
+            if(e.use_from >= 0 && e.use_from < CFG_MAX_SLOTS) {
+                bs_set_range(df.gen[b], e.use_from, df_range_end(e.use_to, CFG_MAX_SLOTS));
+            }
+        }
+    }
+
+    df_solve(cfg, &df);
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        bs_copy(liveness->live_in[b], df.in[b], words);
+        bs_copy(liveness->live_out[b], df.out[b], words);
+    }
+}
+
+/* Definitions writing only one slot, by slot */
+static bitset_word slot_defs[CFG_MAX_SLOTS][BS_WORDS(INSTRUCTIONS_TABLE_SIZE)];
+
+/* Apply the definitions of an instruction to the reaching definitions */
+static void df_reach_transfer(int index, int start, bitset_word* reach, bitset_word* kill) {
+    struct_effects e = it_get_effects(index);
+    int words = BS_WORDS(INSTRUCTIONS_TABLE_SIZE);
+    if(e.nb_defs == 0 && e.clobber_from == -1) {
+        return;
+    }
+    for(int d = 0; d < e.nb_defs; d++) {
+        if(e.defs[d] >= 0 && e.defs[d] < CFG_MAX_SLOTS) {
+            bs_subtract(reach, slot_defs[e.defs[d]], words);
+            if(kill != NULL) {
+                bs_union(kill, slot_defs[e.defs[d]], words);
+            }
+        }
+    }
+    bs_set(reach, index - start);
+}
+
+/* Compute the reaching definitions */
+void df_reaching_definitions(struct_cfg* cfg, struct_reaching* reaching) {
+    static struct_dataflow df;
+    int words = BS_WORDS(INSTRUCTIONS_TABLE_SIZE);
+    df.forward = true;
+    df.intersection = false;
+    df.nb_bits = cfg->end - cfg->start;
+    reaching->start = cfg->start;
+
+    // The definitions killed by a write of each slot
+    memset(slot_defs, 0, sizeof(slot_defs));
+    for(int i = cfg->start; i < cfg->end; i++) {
+        struct_effects e = it_get_effects(i);
+        if(e.nb_defs == 1 && e.clobber_from == -1 && e.defs[0] >= 0 && e.defs[0] < CFG_MAX_SLOTS) {
+            bs_set(slot_defs[e.defs[0]], i - cfg->start);
+        }
+    }
+
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        bs_fill(df.gen[b], 0, words);
+        bs_fill(df.kill[b], 0, words);
+        for(int i = cfg->blocks[b].start; i < cfg->blocks[b].end; i++) {
+            df_reach_transfer(i, cfg->start, df.gen[b], df.kill[b]);
+        }
+    }
+
+    df_solve(cfg, &df);
+    for(int b = 0; b < cfg->nb_blocks; b++) {
+        bs_fill(reaching->reach_in[b], 0, words);
+        bs_fill(reaching->reach_out[b], 0, words);
+        bs_copy(reaching->reach_in[b], df.in[b], BS_WORDS(df.nb_bits));
+        bs_copy(reaching->reach_out[b], df.out[b], BS_WORDS(df.nb_bits));
+    }
+}
+
+/* Find the definitions of a slot reaching an instruction */
+int df_reaching_defs_of(struct_cfg* cfg, struct_reaching* reaching, int index, int slot, int* defs) {
+    static bitset_word reach[BS_WORDS(INSTRUCTIONS_TABLE_SIZE)];
+    int b = cfg_block_of(cfg, index);
+    if(b == -1) {
+        return 0;
+    }
+    bs_copy(reach, reaching->reach_in[b], BS_WORDS(INSTRUCTIONS_TABLE_SIZE));
+    for(int i = cfg->blocks[b].start; i < index; i++) {
+        df_reach_transfer(i, reaching->start, reach, NULL);
+    }
+
+    int nb_defs = 0;
+    for(int i = cfg->start; i < cfg->end; i++) {
+        if(!bs_test(reach, i - cfg->start)) {
+            continue;
+        }
+        struct_effects e = it_get_effects(i);
+        bool writes = e.clobber_from != -1 && slot >= e.clobber_from;
+        for(int d = 0; d < e.nb_defs; d++) {
+            writes = writes || e.defs[d] == slot;
+        }
+        if(writes) {
+            defs[nb_defs++] = i;
+        }
+    }
+    return nb_defs;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file dataflow.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the dataflow analyses
+ *
+ * A dataflow analysis computes a set of elements at the start and at
+ * the end of each basic block of a control flow graph, see cfg.h. Each
+ * block transforms the set with its gen and kill sets:
+ * - forward, out = gen | (in & ~kill), in being the meet of the out of the predecessors
+ * - backward, in = gen | (out & ~kill), out being the meet of the in of the successors
+ *
+ * The meet is the union for the "may" analyses, like liveness, and the
+ * intersection for the "must" analyses, like available expressions. The
+ * sets are bitsets, see bitset.h, and the blocks are visited with a
+ * worklist in reverse postorder, or postorder for a backward analysis,
+ * so that most blocks see their predecessors first.
+ *
+ * The liveness of the slots and the reaching definitions are built on
+ * top of the solver.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef DATAFLOW_H
+#define DATAFLOW_H
+
+#include <stdbool.h> // bool type
+#include "bitset.h"
+#include "cfg.h"
+
+/**
+ * @brief Constant for the maximum number of elements of an analysis
+ */
+#define DF_MAX_BITS 4096
+
+/**
+ * @brief Constant for the number of words of the sets of an analysis
+ */
+#define DF_WORDS BS_WORDS(DF_MAX_BITS)
+
+/**
+ * @brief Structure for a dataflow analysis
+ *
+ * The direction, the meet, the number of elements and the gen and kill
+ * sets of the blocks are given, the in and out sets are computed. Only
+ * the first BS_WORDS(nb_bits) words of each set are used.
+ *
+ * @param forward true for a forward analysis, false for a backward one
+ * @param intersection true if the meet is the intersection, false for the union
+ * @param nb_bits the number of elements, at most DF_MAX_BITS
+ * @param gen the elements generated by each block
+ * @param kill the elements killed by each block
+ * @param in the elements at the start of each block
+ * @param out the elements at the end of each block
+ * @param nb_visits the number of blocks visited by the solver
+ */
+typedef struct {
+    bool forward;
+    bool intersection;
+    int nb_bits;
+    bitset_word gen[CFG_MAX_BLOCKS][DF_WORDS];
+    bitset_word kill[CFG_MAX_BLOCKS][DF_WORDS];
+    bitset_word in[CFG_MAX_BLOCKS][DF_WORDS];
+    bitset_word out[CFG_MAX_BLOCKS][DF_WORDS];
+    int nb_visits;
+} struct_dataflow;
+
+/**
+ * @brief Structure for the liveness of the memory slots
+ *
+ * A slot is live at a point if its value may be read later
+ * before being written.
+ *
+ * @param live_in the live slots at the start of each block
+ * @param live_out the live slots at the end of each block
+ */
+typedef struct {
+    bitset_word live_in[CFG_MAX_BLOCKS][BS_WORDS(CFG_MAX_SLOTS)];
+    bitset_word live_out[CFG_MAX_BLOCKS][BS_WORDS(CFG_MAX_SLOTS)];
+} struct_liveness;
+
+/**
+ * @brief Structure for the reaching definitions
+ *
+ * A definition is an instruction writing a slot, numbered from the
+ * start of the graph. A definition reaches a point if a path goes from
+ * it to the point without writing its slot again. An instruction that
+ * may write several slots, like an ENTER, is only killed by the writes
+ * of the slots it always writes. The values at the entry of the function
+ * are not definitions.
+ *
+ * @param start the index of the first instruction of the graph
+ * @param reach_in the definitions reaching the start of each block
+ * @param reach_out the definitions reaching the end of each block
+ */
+typedef struct {
+    int start;
+    bitset_word reach_in[CFG_MAX_BLOCKS][BS_WORDS(INSTRUCTIONS_TABLE_SIZE)];
+    bitset_word reach_out[CFG_MAX_BLOCKS][BS_WORDS(INSTRUCTIONS_TABLE_SIZE)];
+} struct_reaching;
+
+/**
+ * @brief Solve a dataflow analysis
+ *
+ * The gen and kill sets must be filled. The entry of a forward analysis
+ * and the exits of a backward analysis start from the empty set, the
+ * other blocks from the empty set for a union and the full set for an
+ * intersection. Unreachable blocks are visited after the others.
+ *
+ * @param cfg the control flow graph
+ * @param df the analysis, its in and out sets are filled
+ */
+void df_solve(struct_cfg* cfg, struct_dataflow* df);
+
+/**
+ * @brief Compute the liveness of the memory slots
+ *
+ * This is a backward analysis over the slots: the gen set of a block is
+ * the slots read before being written in the block, the kill set the
+ * slots written in the block.
+ *
+ * @param cfg the control flow graph
+ * @param liveness the liveness to fill
+ */
+void df_liveness(struct_cfg* cfg, struct_liveness* liveness);
+
+/**
+ * @brief Compute the reaching definitions
+ *
+ * This is a forward analysis over the instructions of the graph.
+ *
+ * @param cfg the control flow graph
+ * @param reaching the reaching definitions to fill
+ */
+void df_reaching_definitions(struct_cfg* cfg, struct_reaching* reaching);
+
+/**
+ * @brief Find the definitions of a slot reaching an instruction
+ *
+ * @param cfg the control flow graph
+ * @param reaching the reaching definitions of the graph
+ * @param index the index of the instruction
+ * @param slot the slot
+ * @param defs the indexes of the instructions that may have written the slot
+ * @return int the number of definitions
+ */
+int df_reaching_defs_of(struct_cfg* cfg, struct_reaching* reaching, int index, int slot, int* defs);
+
+#endif // DATAFLOW_H
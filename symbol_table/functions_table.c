@@ -31,6 +31,7 @@ int ft_insert(char *name, int memory_address) {
     }
     strncpy(functions_table[ft_index].name, name, 32);
     functions_table[ft_index].memory_address = memory_address;
+    functions_table[ft_index].nb_params = 0;
     ft_index++;
     return ft_index-1;
 }
@@ -48,6 +49,35 @@ struct_function ft_search_by_address(int address) {
     return functions_table[address];
 }
 
+void ft_set_nb_params(int memory_address, int nb_params) {
+    for(int i = 0; i < ft_index; i++) {
+        if(functions_table[i].memory_address == memory_address) {
+            functions_table[i].nb_params = nb_params;
+        }
+    }
+}
+
+int ft_get_nb_params(int memory_address) {
+    for(int i = 0; i < ft_index; i++) {
+        if(functions_table[i].memory_address == memory_address) {
+            return functions_table[i].nb_params;
+        }
+    }
+    return -1;
+}
+
+int ft_get_count() {
+    return ft_index;
+}
+
+void ft_relocate(int index, int delta) {
+    for(int i = 0; i < ft_index; i++) {
+        if(functions_table[i].memory_address > index) {
+            functions_table[i].memory_address += delta;
+        }
+    }
+}
+
 void ft_clear() {
     ft_index = 0;
 }
@@ -19,11 +19,13 @@
  * 
  * @param name the name of the function
  * @param memory_address the instruction address of the function
+ * @param nb_params the number of parameters of the function
  * 
  */
 typedef struct {
     char name[32];
     int memory_address;
+    int nb_params;
 } struct_function;
 
 /**
@@ -62,6 +64,41 @@ int ft_search(char *name);
  */
 struct_function ft_search_by_address(int address);
 
+/**
+ * @brief Set the number of parameters of a function
+ * 
+ * @param memory_address the instruction address of the function
+ * @param nb_params the number of parameters of the function
+ */
+void ft_set_nb_params(int memory_address, int nb_params);
+
+/**
+ * @brief Get the number of parameters of a function
+ * 
+ * @param memory_address the instruction address of the function
+ * @return int the number of parameters, or -1 if the function is not found
+ */
+int ft_get_nb_params(int memory_address);
+
+/**
+ * @brief Get the number of functions in the functions table
+ * 
+ * @return int the number of functions
+ */
+int ft_get_count();
+
+/**
+ * @brief Relocate the functions after a move of the instructions
+ * 
+ * The memory address of every function starting after the given
+ * instruction index is shifted by delta. It is used when an
+ * instruction is inserted in or removed from the instructions table.
+ * 
+ * @param index the index of the inserted or removed instruction
+ * @param delta the shift of the following instructions
+ */
+void ft_relocate(int index, int delta);
+
 /**
  * @brief Clear the functions table
  * 
@@ -17,6 +17,12 @@ struct_instruction i_table[INSTRUCTIONS_TABLE_SIZE];
 /* Index variable for instructions */
 int it_index = 0;
 
+/* Fingerprint of the instructions generated from the source */
+static int fingerprint_count = 0;
+static unsigned int fingerprint_hash = 0;
+
+extern int line_number; // Defined in lex.c
+
 /* Get the opcode as a string */
 char* it_get_opcode(enum opcode opc) {
     switch(opc) {
@@ -32,6 +38,12 @@ char* it_get_opcode(enum opcode opc) {
             return "MUL";
         case iDIV:
             return "DIV";
+        case iSHL:
+            return "SHL";
+        case iSHR:
+            return "SHR";
+        case iBAND:
+            return "BAND";
         case iEQ:
             return "EQU";
         case iNEQ:
@@ -58,14 +70,10 @@ char* it_get_opcode(enum opcode opc) {
             return "PRI";
         case iNOP:
             return "NOP";
-        case iRET:
-            return "RET";
-        case iPUSH:
-            return "PUSH";
-        case iPOP:
-            return "POP";
-        case iCALL:
-            return "CALL";
+        case iENTER:
+            return "ENTER";
+        case iLEAVE:
+            return "LEAVE";
     }
 }
 
@@ -79,6 +87,8 @@ int it_insert(enum opcode opc, int op1, int op2, int op3) {
     i_table[it_index].op1 = op1;
     i_table[it_index].op2 = op2;
     i_table[it_index].op3 = op3;
+    i_table[it_index].id = it_index + 1;
+    i_table[it_index].line = line_number;
     it_index++;
     return it_index-1;
 }
@@ -88,6 +98,169 @@ int it_get_index() {
     return it_index;
 }
 
+/* Get an instruction of the table */
+struct_instruction it_get(int index) {
+    return i_table[index];
+}
+
+/* Remove the instructions from index to the end of the table */
+void it_rollback(int index) {
+    if(index >= 0 && index < it_index) {
+        it_index = index;
+    }
+}
+
+/* Replace an instruction of the table */
+void it_set(int index, struct_instruction instruction) {
+    if(instruction.id == 0) {
+        instruction.id = i_table[index].id;
+        instruction.line = i_table[index].line;
+    }
+    i_table[index] = instruction;
+}
+
+/* Shift the jump targets and function addresses after index */
+static void it_relocate(int index, int delta) {
+    for(int i = 0; i < it_index; i++) {
+        if(it_get_target(i) > index) {
+            it_set_target(i, it_get_target(i) + delta);
+        }
+    }
+    ft_relocate(index, delta);
+}
+
+/* Insert an instruction at a given index of the table */
+int it_insert_at(int index, enum opcode opc, int op1, int op2, int op3) {
+    if(it_index >= INSTRUCTIONS_TABLE_SIZE) {
+        printf("Error: Instructions table is full\n");
+        return -1;
+    }
+    // Relocate before the insertion, the new instruction keeps its target
+    it_relocate(index, 1);
+    for(int i = it_index; i > index; i--) {
+        i_table[i] = i_table[i-1];
+    }
+    it_index++;
+    i_table[index].opcode = opc;
+    i_table[index].op1 = op1;
+    i_table[index].op2 = op2;
+    i_table[index].op3 = op3;
+    i_table[index].id = 0;
+    i_table[index].line = 0;
+    if(index + 1 < it_index) {
+        i_table[index].line = i_table[index+1].line;
+    } else if(index > 0) {
+        i_table[index].line = i_table[index-1].line;
+    }
+    return index;
+}
+
+/* Remove an instruction from the table */
+void it_remove(int index) {
+    for(int i = index; i < it_index - 1; i++) {
+        i_table[i] = i_table[i+1];
+    }
+    it_index--;
+    it_relocate(index, -1);
+}
+
+/* Get the target of a jump or a call */
+int it_get_target(int index) {
+    switch(i_table[index].opcode) {
+        case iJMP:
+        case iENTER:
+            return i_table[index].op1;
+        case iJMPF:
+            return i_table[index].op2;
+        default:
+            return -1;
+    }
+}
+
+/* Set the target of a jump or a call */
+void it_set_target(int index, int target) {
+    if(i_table[index].opcode == iJMPF) {
+        i_table[index].op2 = target;
+    } else {
+        i_table[index].op1 = target;
+    }
+}
+
+/* Get the slots read and written by an instruction */
+struct_effects it_get_effects(int index) {
+    struct_effects e = {{0, 0}, 0, {0, 0, 0}, 0, -1, -1, -1};
+    struct_instruction in = i_table[index];
+    switch(in.opcode) {
+        case iAFC:
+            e.defs[e.nb_defs++] = in.op1;
+            break;
+        case iCOP:
+            e.defs[e.nb_defs++] = in.op1;
+            e.uses[e.nb_uses++] = in.op2;
+            break;
+        case iNOT:
+            e.defs[e.nb_defs++] = in.op1;
+            e.uses[e.nb_uses++] = in.op1;
+            break;
+        case iJMPF:
+        case iPRINT:
+            e.uses[e.nb_uses++] = in.op1;
+            break;
+        case iLEAVE:
+            // The caller reads the return value
+            e.uses[e.nb_uses++] = 0;
+            break;
+        case iENTER: {
+            // The frame of the call starts at the return value
+            int tsp = in.op2;
+            e.defs[e.nb_defs++] = tsp;
+            e.clobber_from = tsp;
+            e.use_from = tsp + 1;
+            // The arguments, or the whole frame if the function is unknown
+            int nb_params = ft_get_nb_params(in.op1);
+            e.use_to = nb_params == -1 ? -1 : tsp + 1 + nb_params;
+            break;
+        }
+        case iJMP:
+        case iNOP:
+            break;
+        default: // Binary operations
+            e.defs[e.nb_defs++] = in.op1;
+            e.uses[e.nb_uses++] = in.op2;
+            e.uses[e.nb_uses++] = in.op3;
+            break;
+    }
+    return e;
+}
+
+/* Get the operands of an instruction that are memory slots */
+int it_get_slot_operands(struct_instruction* instruction, int* slots[3]) {
+    switch(instruction->opcode) {
+        case iAFC:
+        case iNOT:
+        case iJMPF:
+        case iPRINT:
+            slots[0] = &instruction->op1;
+            return 1;
+        case iENTER:
+            slots[0] = &instruction->op2;
+            return 1;
+        case iCOP:
+            slots[0] = &instruction->op1;
+            slots[1] = &instruction->op2;
+            return 2;
+        case iJMP:
+        case iNOP:
+        case iLEAVE:
+            return 0;
+        default: // Binary operations
+            slots[0] = &instruction->op1;
+            slots[1] = &instruction->op2;
+            slots[2] = &instruction->op3;
+            return 3;
+    }
+}
+
 /* Patch the first operand of an instruction: JMP */
 void it_patch_op1(int index, int op) {
     i_table[index].op1 = op;
@@ -98,6 +271,46 @@ void it_patch_op2(int index, int op) {
     i_table[index].op2 = op;
 }
 
+/* Check the instructions table, returns the number of errors */
+int it_verify() {
+    int errors = 0;
+    for(int i = 0; i < it_index; i++) {
+        struct_instruction in = i_table[i];
+        if(in.opcode < iAFC || in.opcode > iLEAVE) {
+            printf("Error: instruction 0x%02x has an unknown opcode %d\n", i, in.opcode);
+            errors++;
+            continue;
+        }
+        int* slots[3];
+        int n = it_get_slot_operands(&in, slots);
+        for(int s = 0; s < n; s++) {
+            if(*slots[s] < 0) {
+                printf("Error: instruction 0x%02x %s uses the negative slot %d\n", i, it_get_opcode(in.opcode), *slots[s]);
+                errors++;
+            }
+        }
+        if((in.opcode == iJMP || in.opcode == iJMPF) && (it_get_target(i) < 0 || it_get_target(i) >= it_index)) {
+            printf("Error: instruction 0x%02x %s jumps to %d, outside of the table\n", i, it_get_opcode(in.opcode), it_get_target(i));
+            errors++;
+        }
+        if(in.opcode == iENTER && ft_get_nb_params(in.op1) == -1) {
+            printf("Error: instruction 0x%02x ENTER targets %d, which is not a function\n", i, in.op1);
+            errors++;
+        }
+    }
+    for(int f = 0; f < ft_get_count(); f++) {
+        int start = ft_search_by_address(f).memory_address;
+        if(start <= 0 || start >= it_index) {
+            printf("Error: function %s starts at %d, outside of the table\n", ft_search_by_address(f).name, start);
+            errors++;
+        } else if(i_table[start-1].opcode != iLEAVE && i_table[start-1].opcode != iJMP) {
+            printf("Error: instruction 0x%02x falls through into function %s\n", start - 1, ft_search_by_address(f).name);
+            errors++;
+        }
+    }
+    return errors;
+}
+
 /* Print the assembly code into a FILE */
 void it_print_asm() {
     FILE *file;
@@ -120,10 +333,10 @@ void it_print_asm() {
         }
 
         enum opcode opc = i_table[i].opcode;
-        if(opc == iAFC || opc == iCOP || opc == iJMPF) {
+        if(opc == iAFC || opc == iCOP || opc == iJMPF || opc == iENTER) {
             fprintf(file,"%s %d %d\n", it_get_opcode(i_table[i].opcode), i_table[i].op1, i_table[i].op2);
             continue;
-        } else if (opc==iNOT || opc==iJMP || opc==iPRINT || opc==iRET || opc==iPUSH || opc==iPOP || opc==iCALL) {
+        } else if (opc==iNOT || opc==iJMP || opc==iPRINT || opc==iLEAVE) {
             fprintf(file,"%s %d\n", it_get_opcode(i_table[i].opcode), i_table[i].op1);
             continue;
         } else if (opc==iNOP) {
@@ -137,6 +350,39 @@ void it_print_asm() {
     fclose(file);
 }
 
+/* Record the fingerprint of the instructions table, FNV-1a of the instructions and their lines */
+void it_set_fingerprint() {
+    unsigned int hash = 2166136261u;
+    for(int i = 0; i < it_index; i++) {
+        int fields[] = {i_table[i].opcode, i_table[i].op1, i_table[i].op2, i_table[i].op3, i_table[i].line};
+        for(int f = 0; f < 5; f++) {
+            hash = (hash ^ (unsigned int)fields[f]) * 16777619u;
+        }
+    }
+    fingerprint_count = it_index;
+    fingerprint_hash = hash;
+}
+
+/* Get the fingerprint recorded by it_set_fingerprint */
+int it_get_fingerprint(unsigned int* hash) {
+    *hash = fingerprint_hash;
+    return fingerprint_count;
+}
+
+/* Print the ids and lines of the instructions into a FILE */
+void it_print_map() {
+    FILE *file = fopen("asm.map", "w");
+    if(file == NULL) {
+        return;
+    }
+    fprintf(file, "# fingerprint %d %08x\n", fingerprint_count, fingerprint_hash);
+    fprintf(file, "# index id line\n");
+    for(int i = 0; i < it_index; i++) {
+        fprintf(file, "%d %d %d\n", i, i_table[i].id, i_table[i].line);
+    }
+    fclose(file);
+}
+
 /* Print the assembly code into the console */
 void it_pretty_print() {
 
@@ -159,10 +405,10 @@ void it_pretty_print() {
 
         enum opcode opc = i_table[i].opcode;
 
-        if(opc == iAFC || opc == iCOP || opc == iJMPF) {
+        if(opc == iAFC || opc == iCOP || opc == iJMPF || opc == iENTER) {
             printf("0x%02x\t %-5s %-4d %-4d\n", i, it_get_opcode(i_table[i].opcode), i_table[i].op1, i_table[i].op2);
             continue;
-        } else if (opc==iNOT || opc==iJMP || opc==iPRINT || opc==iRET || opc==iPUSH || opc==iPOP || opc==iCALL) {
+        } else if (opc==iNOT || opc==iJMP || opc==iPRINT || opc==iLEAVE) {
             printf("0x%02x\t %-5s %-4d\n", i, it_get_opcode(i_table[i].opcode), i_table[i].op1);
             continue;
         } else if (opc==iNOP) {
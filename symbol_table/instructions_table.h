@@ -14,6 +14,9 @@
  * - SOU: Subtraction
  * - MUL: Multiplication
  * - DIV: Division
+ * - SHL: Shift left
+ * - SHR: Arithmetic shift right
+ * - BAND: Bitwise AND
  * - EQ: Equal
  * - NEQ: Not equal
  * - LT: Less than
@@ -27,6 +30,16 @@
  * - JMPF: Jump if false
  * - PRINT: Print a value
  * - NOP: No operation
+ * - ENTER: Call a function in a new frame
+ * - LEAVE: Return from a function
+ *
+ * A frame holds the return value of the function in its slot 0, then its
+ * parameters. ENTER f tsp saves the address of the next instruction and
+ * the current frame on a return stack internal to the machine, moves the
+ * frame tsp slots up and jumps to f. LEAVE pops the return stack and goes
+ * back to the caller, which finds the return value in slot tsp. The return
+ * addresses are not in the memory, so a write cannot overwrite them, and
+ * LEAVE in the outermost frame ends the program.
  *  
  * @version 0.1
  * @date 2024-04-10
@@ -58,6 +71,11 @@
  * @param op1 the first operand of the instruction
  * @param op2 the second operand of the instruction
  * @param op3 the third operand of the instruction
+ * @param id the number of the instruction when it was parsed, plus one, 0
+ *           for an instruction created by an optimization. It stays the
+ *           same between two compilations of the same source, so that a
+ *           profile can be read back, see profile.h
+ * @param line the line of the source the instruction comes from, 0 if unknown
  * 
  */
 typedef struct {
@@ -65,6 +83,8 @@ typedef struct {
     int op1;
     int op2;
     int op3;
+    int id;
+    int line;
 } struct_instruction;
 
 /**
@@ -82,6 +102,9 @@ typedef struct {
  * @param iSOU Subtraction
  * @param iMUL Multiplication
  * @param iDIV Division
+ * @param iSHL Shift left
+ * @param iSHR Arithmetic shift right
+ * @param iBAND Bitwise AND
  * @param iEQ Equal
  * @param iNEQ Not equal
  * @param iLT Less than
@@ -95,13 +118,40 @@ typedef struct {
  * @param iJMPF Jump if false
  * @param iPRINT Print a value
  * @param iNOP No operation
- * @param iRET Return
- * @param iPUSH Push a value on the stack
- * @param iPOP Pop a value from the stack
- * @param iCALL Call a function
+ * @param iENTER Call a function in a new frame
+ * @param iLEAVE Return from a function
  * 
  */
-enum opcode { iAFC, iCOP, iADD, iSOU, iMUL, iDIV, iEQ, iNEQ, iLT, iLE,  iGT, iGE, iAND, iOR, iNOT, iJMP, iJMPF, iPRINT, iNOP, iRET, iPUSH, iPOP, iCALL};
+enum opcode { iAFC, iCOP, iADD, iSOU, iMUL, iDIV, iSHL, iSHR, iBAND, iEQ, iNEQ, iLT, iLE,  iGT, iGE, iAND, iOR, iNOT, iJMP, iJMPF, iPRINT, iNOP, iENTER, iLEAVE};
+
+/**
+ * @brief Structure for the memory effects of an instruction
+ * 
+ * The operands of the instructions are memory slots relative to the
+ * current frame. This structure tells which slots an instruction reads
+ * and writes. It is used by the optimizations of the instructions table.
+ * 
+ * An ENTER writes the return value of the new frame for sure, but the
+ * called function may also write any slot of its frame and reads its
+ * arguments. These slots are given as ranges.
+ * 
+ * @param defs the slots written by the instruction
+ * @param nb_defs the number of slots written
+ * @param uses the slots read by the instruction
+ * @param nb_uses the number of slots read
+ * @param clobber_from every slot from this one may be written, -1 if none
+ * @param use_from every slot from this one may be read, -1 if none
+ * @param use_to the end of the slots read from use_from, -1 for no end
+ */
+typedef struct {
+    int defs[2];
+    int nb_defs;
+    int uses[3];
+    int nb_uses;
+    int clobber_from;
+    int use_from;
+    int use_to;
+} struct_effects;
 
 /**
  * @brief Get the opcode of an instruction
@@ -124,6 +174,9 @@ char* it_get_opcode(enum opcode opc);
  * If the instruction requires less than 3 operands, set the unused
  * operands to 0.
  * 
+ * The instruction is numbered by its index and tagged with the
+ * current line of the source.
+ * 
  * If the table is full, the function prints an error message and
  * returns -1.
  * 
@@ -145,6 +198,111 @@ int it_insert(enum opcode opcode, int op1, int op2, int op3);
  */
 int it_get_index();
 
+/**
+ * @brief Get an instruction of the table
+ * 
+ * This function returns a copy of the instruction stored at the
+ * given index of the instructions table. It is used to inspect the
+ * instructions already generated, e.g. to recognize a call sequence.
+ * 
+ * @param index the index of the instruction in the table
+ * @return struct_instruction the instruction at the given index
+ */
+struct_instruction it_get(int index);
+
+/**
+ * @brief Rollback the instructions table to a given index
+ * 
+ * This function removes all the instructions from the given index
+ * to the end of the table. It is used to replace a sequence of
+ * instructions that has just been generated by a better one.
+ * 
+ * @param index the index of the first instruction to remove
+ */
+void it_rollback(int index);
+
+/**
+ * @brief Replace an instruction of the table
+ * 
+ * A new instruction, without id, keeps the id and the line of the
+ * instruction it replaces: it is the same instruction rewritten.
+ * 
+ * @param index the index of the instruction in the table
+ * @param instruction the new instruction
+ */
+void it_set(int index, struct_instruction instruction);
+
+/**
+ * @brief Insert an instruction at a given index of the table
+ * 
+ * The instructions from the index are shifted by one. The jump and
+ * call targets and the function addresses are relocated: a target
+ * equal to the index now reaches the inserted instruction.
+ * 
+ * The new instruction has no id, it takes the line of the instruction
+ * it is inserted before.
+ * 
+ * If the table is full, the function prints an error message and
+ * returns -1.
+ * 
+ * @param index the index of the new instruction
+ * @param opcode the opcode of the instruction
+ * @param op1 the first operand of the instruction
+ * @param op2 the second operand of the instruction
+ * @param op3 the third operand of the instruction
+ * @return int the index of the instruction in the table
+ */
+int it_insert_at(int index, enum opcode opcode, int op1, int op2, int op3);
+
+/**
+ * @brief Remove an instruction from the table
+ * 
+ * The instructions after the index are shifted by one. The jump and
+ * call targets and the function addresses are relocated: a target
+ * equal to the index now reaches the next instruction.
+ * 
+ * @param index the index of the instruction to remove
+ */
+void it_remove(int index);
+
+/**
+ * @brief Get the target of a jump or a call
+ * 
+ * @param index the index of the instruction in the table
+ * @return int the target of a JMP, JMPF or ENTER instruction, -1 otherwise
+ */
+int it_get_target(int index);
+
+/**
+ * @brief Set the target of a jump or a call
+ * 
+ * @param index the index of a JMP, JMPF or ENTER instruction
+ * @param target the new target of the instruction
+ */
+void it_set_target(int index, int target);
+
+/**
+ * @brief Get the memory effects of an instruction
+ * 
+ * @see struct_effects
+ * 
+ * @param index the index of the instruction in the table
+ * @return struct_effects the slots read and written by the instruction
+ */
+struct_effects it_get_effects(int index);
+
+/**
+ * @brief Get the operands of an instruction that are memory slots
+ * 
+ * The pointers point into the given instruction, so that the slots
+ * can be renamed. The frame offset of ENTER is a slot as well.
+ * 
+ * @param instruction the instruction
+ * @param slots the pointers to the slot operands
+ * @return int the number of slot operands
+ */
+int it_get_slot_operands(struct_instruction* instruction, int* slots[3]);
+
 /**
  * @brief Patch the first operand of an instruction
  * 
@@ -169,6 +327,21 @@ void it_patch_op1(int index, int op);
  */
 void it_patch_op2(int index, int op);
 
+/**
+ * @brief Check the instructions table
+ * 
+ * This function checks that every instruction has a known opcode, that
+ * its slot operands are not negative, that the jumps target an
+ * instruction of the table and that the calls target the start of a
+ * function. The code before a function must not fall through into it:
+ * it ends with a LEAVE or a JMP.
+ * 
+ * Each error is printed with the index of the instruction.
+ * 
+ * @return int the number of errors found
+ */
+int it_verify();
+
 /**
  * @brief Print the assembly code to a file
  * 
@@ -187,6 +360,43 @@ void it_patch_op2(int index, int op);
  */
 void it_print_asm();
 
+/**
+ * @brief Record the fingerprint of the instructions table
+ * 
+ * This function hashes the opcode, the operands and the source line of
+ * every instruction. It is called on the instructions generated from
+ * the source, before the passes change them, so that two compilations
+ * of the same source get the same fingerprint whatever their passes.
+ * 
+ */
+void it_set_fingerprint();
+
+/**
+ * @brief Get the fingerprint recorded by it_set_fingerprint
+ * 
+ * @param hash the hash of the instructions
+ * @return int the number of instructions, 0 if none has been recorded
+ */
+int it_get_fingerprint(unsigned int* hash);
+
+/**
+ * @brief Print the map of the assembly code into a file
+ * 
+ * This function prints the id and the source line of each instruction
+ * of the assembly code to the file asm.map, one line per instruction:
+ * 
+ * index id line
+ * 
+ * The map starts with the fingerprint of the program, see
+ * it_set_fingerprint:
+ * 
+ * # fingerprint count hash
+ * 
+ * The interpreter uses it to key its profile, see profile.h.
+ * 
+ */
+void it_print_map();
+
 /**
  * @brief Print the instructions table
  * 
@@ -12,7 +12,10 @@
       - ADD: Add two values and store the result in a memory location
       - SOU: Subtract two values and store the result in a memory location
       - MUL: Multiply two values and store the result in a memory location
-      - DIV: Divide two values and store the result in a memory location
+      - DIV: Divide two values and store the result in a memory location, rounding toward zero as in C
+      - SHL: Shift a value left and store the result in a memory location
+      - SHR: Shift a value right, keeping its sign, and store the result in a memory location
+      - BAND: Compute the bitwise AND of two values and store the result in a memory location
       - EQU: Check if two values are equal and store the result in a memory location
       - NEQ: Check if two values are not equal and store the result in a memory location
       - LT: Check if a value is less than another and store the result in a memory location
@@ -25,12 +28,33 @@
       - JMP: Jump to a specific instruction
       - JMF: Jump to a specific instruction if a condition is met
       - PRI: Print a value
-      - PUSH: Increase the memory offset / move the stack frame
-      - POP: Decrease the memory offset / move the stack frame
-      - CALL: Call a function
-      - RET: Return from a function
+      - ENTER: Call a function, moving the stack frame up by a given number of slots
+      - LEAVE: Return from a function, or stop the program when returning from main
       - NOP: Do nothing
+
+    Usage: python3 interpreter.py [--profile[=file]] [--max-iter=n] [--bench]
+
+    The program is verified once when it is loaded, see verify(): an invalid
+    program is rejected, and a valid one is decoded once into a handler per
+    instruction, see decode(), then runs in a loop that does not check the
+    instructions, the slots or the jumps again. The program stops after
+    max_iter instructions, 5000 by default, or n with --max-iter=n, 0 for no
+    limit. With --bench, the number of instructions per second is printed.
+
+    The return addresses are not stored in the memory: ENTER pushes the address
+    of the next instruction and the frame of the caller on a return stack of the
+    interpreter, and LEAVE pops them, so a write to the memory cannot change where
+    a function returns. Slot 0 of a frame holds the return value of the function.
+
+    With --profile, the number of executions of each block, JMF and ENTER is
+    written to a profile, profile.txt by default, keyed by the index of the
+    instruction and by the id and source line given in "asm.map" by the
+    compiler. The fingerprint of the program at the top of "asm.map" is copied
+    to the profile, so that the compiler ignores a profile taken on another
+    program. The compiler reads it back with --profile-use, see profile.h.
 """
+import os
+import sys
 import time
 
 # Read the assembly code from the file
@@ -39,19 +63,39 @@ lines = open(filename, "r").readlines()
 asm_raw = [l.split() for l in lines]
 
 # Remove empty lines, commments and labels
+# The labels give the first instruction of each function
 asm_clean = []
+functions: dict[int, str] = {} # Index of the first instruction of each function -> name
 for e in asm_raw:
+    if e != [] and e[0].startswith(".") and e[0] != ".entry_point:":
+        functions[len(asm_clean)] = e[0][1:].rstrip(":")
     if e==[] or e[0].startswith("#") or e[0].startswith("\n") or e[0].startswith("."): 
         continue
     asm_clean.append(e)
 
+# Convert an operand to an integer, None if it is not one
+def operand(x):
+    try:
+        return int(x)
+    except ValueError:
+        return None
+
 # Convert the assembly code to a list of tuples of the form
 # (instruction, arg1, arg2, arg3)
-asm: list[tuple[str, int, int, int]] = [[l[0]] + [int(x) for x in l[1:]] for l in asm_clean] # type: ignore
+asm: list[tuple[str, int, int, int]] = [[l[0]] + [operand(x) for x in l[1:]] for l in asm_clean] # type: ignore
+
+# Initialize the memory, it grows when an access goes past its end: the
+# IndexError raised by the list plays the part of a guard page, it is caught
+# around the loop, which never checks the addresses itself. The memory is
+# doubled and the instruction runs again, up to MEMORY_CELLS cells, past
+# which the access is reported as a stack overflow.
+INITIAL_CELLS = 256     # Number of cells of the memory when the program starts
+MEMORY_CELLS = 1 << 22  # Maximum number of cells of the memory
+SHOWN_CELLS = 256       # Number of cells printed at the end of the execution
+mem = [0] * INITIAL_CELLS
 
-# Initialize the memory, its size is 256 bytes
-# if the memory is too small, the program will crash
-mem = [0] * 256 
+# Return stack, a pair (return address, frame of the caller) per call
+returns: list[tuple[int, int]] = []
 
 
 # Initialize the interpreter
@@ -59,108 +103,592 @@ show_memory: bool = True # Set to True to print the memory at the end of the exe
 debug: bool = False     # Set to True to print debug information
 memoryOffset: int = 0   # The memory offset, used to simulate the stack pointer
 ip: int = 0             # The instruction pointer
-max_iter: int = 5000    # The maximum number of iterations before stopping the program
+max_iter: int = 5000    # The maximum number of iterations before stopping the program, set by --max-iter=n
 iter: int = 0           # The current iteration
+bench: bool = False     # Set by --bench to print the number of instructions per second
+
+# Command line options
+profile_file = None
+for arg in sys.argv[1:]:
+    if arg == "--profile":
+        profile_file = "profile.txt"
+    elif arg.startswith("--profile="):
+        profile_file = arg[len("--profile="):]
+    elif arg.startswith("--max-iter=") and arg[len("--max-iter="):].isdigit():
+        max_iter = int(arg[len("--max-iter="):])
+    elif arg == "--bench":
+        bench = True
+    else:
+        print("usage: python3 interpreter.py [--profile[=file]] [--max-iter=n] [--bench]")
+        sys.exit(1)
+if max_iter == 0:
+    max_iter = sys.maxsize
+counts = [0] * len(asm) # Number of executions of each instruction
+taken = [0] * len(asm)  # Number of jumps of each JMF
+
+
+# Number of operands of each instruction
+OPERANDS = {"AFC": 2, "COP": 2, "ADD": 3, "SOU": 3, "MUL": 3, "DIV": 3, "SHL": 3, "SHR": 3, "BAND": 3,
+            "EQU": 3, "NEQ": 3, "LT": 3, "LE": 3, "GT": 3, "GE": 3, "NOT": 1, "AND": 3, "OR": 3,
+            "JMP": 1, "JMF": 2, "PRI": 1, "ENTER": 2, "LEAVE": 1, "NOP": 1}
+
+# Opcode integer of each instruction, used by the fast mode
+OPCODES = {op: k for k, op in enumerate(OPERANDS)}
+
+# Operands that are memory slots
+SLOTS = {op: [1, 2, 3] for op in OPERANDS if OPERANDS[op] == 3}
+SLOTS.update({"AFC": [1], "COP": [1, 2], "NOT": [1], "JMF": [1], "PRI": [1], "ENTER": [2]})
+
+
+def verify():
+    """
+    Check the program once, when it is loaded, so that it can run without checks:
+      - each instruction is known and has its number of integer operands
+      - the slots are not negative, nor the frame offsets of the ENTER
+      - a jump stays in its function, an ENTER goes to the first instruction of a
+        function, and only the entry point jumps to a function, to start main
+      - a function does not fall through into the next one, the program stops
+        after its last instruction or when main returns
+    The frame of a function is its largest slot plus one, the frame of main must fit in
+    the memory. Returns the list of errors and the frame of each function, by the index
+    of its first instruction.
+    """
+    errors = []
+    frames = {}
+    starts = sorted(set([0] + list(functions)))
+    for k, start in enumerate(starts):
+        end = starts[k + 1] if k + 1 < len(starts) else len(asm)
+        name = functions.get(start, "entry_point")
+        frame = 1
+        for i in range(start, end):
+            ins = asm[i]
+            where = "at %d (%s) in %s" % (i, " ".join(str(x) for x in ins), name)
+            if ins[0] not in OPERANDS:
+                errors.append("unknown instruction " + where)
+                continue
+            if len(ins) != OPERANDS[ins[0]] + 1 or None in ins:
+                errors.append("invalid operands " + where)
+                continue
+            for o in SLOTS.get(ins[0], []):
+                if ins[o] < 0:
+                    errors.append("negative slot " + where)
+                frame = max(frame, ins[o] + 1)
+            if ins[0] == "JMP" or ins[0] == "JMF":
+                target = ins[1] if ins[0] == "JMP" else ins[2]
+                entry = start not in functions and target in functions
+                if not (start <= target < end) and not entry:
+                    errors.append("jump out of the function " + where)
+            elif ins[0] == "ENTER" and ins[1] not in functions:
+                errors.append("call of an address that is not a function " + where)
+        if start < end < len(asm) and asm[end - 1][0] not in ("JMP", "LEAVE"):
+            errors.append("fall through out of " + name)
+        frames[start] = frame
+    if asm == []:
+        errors.append("the program is empty")
+    for start in functions:
+        if functions[start] == "main" and frames[start] > MEMORY_CELLS:
+            errors.append("the frame of main does not fit in the memory")
+    return errors, frames
+
+
+def grow_memory():
+    """
+    Double the memory after an access past its end, returns False if it
+    already has MEMORY_CELLS cells
+    """
+    if len(mem) >= MEMORY_CELLS:
+        return False
+    mem.extend([0] * min(len(mem), MEMORY_CELLS - len(mem)))
+    return True
+
+
+def function_of(index):
+    """
+    Name of the function of an instruction
+    """
+    starts = [start for start in functions if start <= index]
+    return functions[max(starts)] if starts else "entry_point"
+
+
+def stack_overflow(ip):
+    """
+    Report a stack overflow with the chain of the calls, read from the return
+    stack: each return address follows the ENTER of a call. The stack overflows
+    when the memory or the return stack is full.
+    """
+    print("Error: stack overflow at %d in %s, the memory has %d cells and the return stack %d calls"
+          % (ip, function_of(ip), len(mem), len(returns)))
+    if asm[ip][0] == "ENTER":
+        print("  calling " + functions[asm[ip][1]])
+    chain = [function_of(ip)] + [function_of(ret - 1) for ret, _ in reversed(returns)]
+    # Recursive calls are shown once with their number
+    k = 0
+    while k < len(chain):
+        same = 1
+        while k + same < len(chain) and chain[k + same] == chain[k]:
+            same += 1
+        print("  in " + chain[k] + (" (x%d)" % same if same > 1 else ""))
+        k += same
+
+
+# Handler factories of the fast mode, see decode(). A factory takes the operands
+# of an instruction and its index, and returns the handler of the instruction:
+# a closure that takes the frame offset and returns the index of the next one.
+# The memory is bound as a default argument, the quickest variable to read.
+def h_afc(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = b
+        return n
+    return h
+
+
+def h_cop(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o]
+        return n
+    return h
+
+
+def h_add(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] + m[c + o]
+        return n
+    return h
+
+
+def h_sou(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] - m[c + o]
+        return n
+    return h
+
+
+def h_mul(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] * m[c + o]
+        return n
+    return h
+
+
+def h_div(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        x, y = m[b + o], m[c + o]
+        q = abs(x) // abs(y)
+        m[a + o] = q if (x < 0) == (y < 0) else -q
+        return n
+    return h
+
+
+def h_shl(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] << m[c + o]
+        return n
+    return h
+
+
+def h_shr(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] >> m[c + o]
+        return n
+    return h
+
+
+def h_band(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] & m[c + o]
+        return n
+    return h
+
+
+def h_equ(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] == m[c + o]
+        return n
+    return h
+
+
+def h_neq(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] != m[c + o]
+        return n
+    return h
 
 
+def h_lt(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] < m[c + o]
+        return n
+    return h
+
+
+def h_le(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] <= m[c + o]
+        return n
+    return h
+
+
+def h_gt(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] > m[c + o]
+        return n
+    return h
+
+
+def h_ge(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] >= m[c + o]
+        return n
+    return h
+
+
+def h_not(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = not m[a + o]
+        return n
+    return h
+
+
+def h_and(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] and m[c + o]
+        return n
+    return h
+
+
+def h_or(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        m[a + o] = m[b + o] or m[c + o]
+        return n
+    return h
+
+
+def h_jmp(a, b, c, i):
+    back = ~i
+    if a <= i:
+        return lambda o: back
+    return lambda o: a
+
+
+def h_jmf(a, b, c, i):
+    n, target = i + 1, (~i if b <= i else b)
+    def h(o, m=mem):
+        return n if m[a + o] else target
+    return h
+
+
+def h_pri(a, b, c, i):
+    n = i + 1
+    def h(o, m=mem):
+        print(m[a + o])
+        return n
+    return h
+
+
+def h_frame(a, b, c, i):
+    # ENTER and LEAVE, run by run_fast()
+    frame = ~i
+    return lambda o: frame
+
+
+def h_nop(a, b, c, i):
+    n = i + 1
+    return lambda o: n
+
+
+# Dispatch table of the fast mode: the handler factory of each opcode integer
+HANDLERS = [{"AFC": h_afc, "COP": h_cop, "ADD": h_add, "SOU": h_sou, "MUL": h_mul, "DIV": h_div,
+             "SHL": h_shl, "SHR": h_shr, "BAND": h_band, "EQU": h_equ, "NEQ": h_neq, "LT": h_lt,
+             "LE": h_le, "GT": h_gt, "GE": h_ge, "NOT": h_not, "AND": h_and, "OR": h_or,
+             "JMP": h_jmp, "JMF": h_jmf, "PRI": h_pri, "ENTER": h_frame, "LEAVE": h_frame,
+             "NOP": h_nop}[op] for op in OPCODES]
+
+
+def decode():
+    """
+    Decode the verified program once: each instruction gets its opcode integer,
+    see OPCODES, and a handler closure built by the factory of its opcode in the
+    dispatch table HANDLERS. A handler takes the frame offset and returns the
+    index of the next instruction, with its operands and its successor already
+    bound, so running an instruction is a single call.
+    The calls, the returns and the jumps back return the bitwise complement of
+    their own index instead, a negative number, so that run_fast() handles them:
+    they change the frame, or check the cap on the number of instructions.
+    Returns the handlers and the decoded instructions (opcode, arg1, arg2, arg3).
+    """
+    code = []
+    fns = []
+    for i, ins in enumerate(asm):
+        opcode = OPCODES[ins[0]]
+        a, b, c = (list(ins[1:]) + [0, 0, 0])[:3]
+        code.append((opcode, a, b, c))
+        fns.append(HANDLERS[opcode](a, b, c, i))
+    # Past the last instruction, the program stops
+    code.append((-1, 0, 0, 0))
+    fns.append(h_frame(0, 0, 0, len(asm)))
+    return fns, code
+
+
+def run_fast():
+    """
+    Run a verified program, decoded once by decode(). The instructions, their
+    operands and the jumps have been checked by verify(), so nothing is checked
+    again: an access past the end of the memory is caught to grow it, and only
+    the jumps back and the calls, which leave the handlers to this loop, stop
+    the program after max_iter instructions. A call is a stack overflow when
+    the return stack already holds MEMORY_CELLS calls, as a frame may start
+    where the frame of its caller starts.
+    Returns the number of executed instructions.
+    """
+    fns, code = decode()
+    rs = returns
+    ENTER, LEAVE, JMP = OPCODES["ENTER"], OPCODES["LEAVE"], OPCODES["JMP"]
+    cap = max_iter
+    offset = 0
+    ip = 0
+    n = 0
+    while True:
+        try:
+            while True:
+                n += 1
+                ip = fns[ip](offset)
+                if ip >= 0:
+                    continue
+                # A call, a return, a jump back or the end of the program
+                ip = ~ip
+                opcode, a, b, c = code[ip]
+                if opcode == ENTER:
+                    if n >= cap:
+                        return n
+                    if len(rs) >= MEMORY_CELLS:
+                        stack_overflow(ip)
+                        return n
+                    rs.append((ip + 1, offset))
+                    offset += b
+                    ip = a
+                elif opcode == LEAVE:
+                    if not rs:
+                        return n # Return from main
+                    ip, offset = rs.pop()
+                elif opcode == -1:
+                    return n - 1 # Past the last instruction
+                elif n >= cap:
+                    return n
+                else:
+                    ip = a if opcode == JMP else b
+        except IndexError:
+            n -= 1 # The instruction runs again
+            if not grow_memory():
+                stack_overflow(ip)
+                return n
+
+
+# Verify the program before running it
+errors, frames = verify()
+if errors:
+    for e in errors:
+        print("Error: " + e)
+    sys.exit(1)
+
 # Execute the program
-while ip < len(asm) and iter < max_iter:
-    iter += 1
-
-    # Print debug information
-    if debug:
-        print("\n")
-        print("ip: " + str(ip))
-        print("memoryOffset: " + str(memoryOffset))
-        print("mem: " + str(mem))
-        print("asm[ip]: " + str(asm[ip]))
+# The profile and the debug information need the checked loop
+started = time.perf_counter()
+if profile_file or debug:
+    while True:
+        try:
+            while ip < len(asm) and iter < max_iter:
+                iter += 1
+                if profile_file:
+                    counts[ip] += 1
+
+                # Print debug information
+                if debug:
+                    print("\n")
+                    print("ip: " + str(ip))
+                    print("memoryOffset: " + str(memoryOffset))
+                    print("mem: " + str(mem[:SHOWN_CELLS]))
+                    print("asm[ip]: " + str(asm[ip]))
     
-    # Sleep for 0.05 seconds, to slow down the execution
-    # time.sleep(0.05)  
-
-    # Execute the instruction
-    # The compiler is memory based, so the memory is used to store the values
-    # The memory offset allows to simulate the stack pointer
-
-    if asm[ip][0] == "AFC":
-        mem[asm[ip][1] + memoryOffset] = asm[ip][2]
-        ip += 1
-    elif asm[ip][0] == "COP":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "ADD":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] + mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "SOU":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] - mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "MUL":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] * mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "DIV":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] // mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "EQU":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] == mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "NEQ":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] != mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "LT":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] < mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "LE":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] <= mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "GT":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] > mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "GE":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] >= mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "NOT":
-        mem[asm[ip][1] + memoryOffset] = not mem[asm[ip][1] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "AND":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] and mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "OR":
-        mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] or mem[asm[ip][3] + memoryOffset]
-        ip += 1
-    elif asm[ip][0] == "JMP":
-        ip = asm[ip][1]
-    elif asm[ip][0] == "JMF":
-        if not mem[asm[ip][1] + memoryOffset]:
-            ip = asm[ip][2]
-            if debug:
-                print(mem[asm[ip][1] + memoryOffset])
-                print("Jumping to " + str(ip) + "because of: " + str(mem[asm[ip][1]]))
-        else:
-            ip += 1
-            if debug:
-                print("Not jumping")
-    elif asm[ip][0] == "PRI":
-        print(mem[asm[ip][1]] + memoryOffset)
-        ip += 1
-    elif asm[ip][0] == "PUSH":
-        memoryOffset += asm[ip][1]
-        ip += 1
-    elif asm[ip][0] == "POP":
-        memoryOffset -= asm[ip][1]
-        ip += 1
-    elif asm[ip][0] == "CALL":
-        mem[memoryOffset] = ip + 1
-        ip = asm[ip][1]
-    elif asm[ip][0] == "RET":
-        ip = mem[memoryOffset]
-
-    elif asm[ip][0] == "NOP":
-        break
-    else:
-        print("Unknown instruction: " + asm[ip][0])
-        break
+                # Sleep for 0.05 seconds, to slow down the execution
+                # time.sleep(0.05)  
+
+                # Execute the instruction
+                # The compiler is memory based, so the memory is used to store the values
+                # The memory offset allows to simulate the stack pointer
+
+                if asm[ip][0] == "AFC":
+                    mem[asm[ip][1] + memoryOffset] = asm[ip][2]
+                    ip += 1
+                elif asm[ip][0] == "COP":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "ADD":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] + mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "SOU":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] - mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "MUL":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] * mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "DIV":
+                    # Integer division rounds toward zero, as in C (Python's // rounds down)
+                    a, b = mem[asm[ip][2] + memoryOffset], mem[asm[ip][3] + memoryOffset]
+                    q = abs(a) // abs(b)
+                    mem[asm[ip][1] + memoryOffset] = q if (a < 0) == (b < 0) else -q
+                    ip += 1
+                elif asm[ip][0] == "SHL":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] << mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "SHR":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] >> mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "BAND":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] & mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "EQU":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] == mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "NEQ":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] != mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "LT":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] < mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "LE":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] <= mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "GT":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] > mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "GE":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] >= mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "NOT":
+                    mem[asm[ip][1] + memoryOffset] = not mem[asm[ip][1] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "AND":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] and mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "OR":
+                    mem[asm[ip][1] + memoryOffset] = mem[asm[ip][2] + memoryOffset] or mem[asm[ip][3] + memoryOffset]
+                    ip += 1
+                elif asm[ip][0] == "JMP":
+                    ip = asm[ip][1]
+                elif asm[ip][0] == "JMF":
+                    if not mem[asm[ip][1] + memoryOffset]:
+                        if profile_file:
+                            taken[ip] += 1
+                        ip = asm[ip][2]
+                        if debug:
+                            print(mem[asm[ip][1] + memoryOffset])
+                            print("Jumping to " + str(ip) + "because of: " + str(mem[asm[ip][1]]))
+                    else:
+                        ip += 1
+                        if debug:
+                            print("Not jumping")
+                elif asm[ip][0] == "PRI":
+                    print(mem[asm[ip][1] + memoryOffset])
+                    ip += 1
+                elif asm[ip][0] == "ENTER":
+                    if len(returns) >= MEMORY_CELLS:
+                        stack_overflow(ip)
+                        break
+                    returns.append((ip + 1, memoryOffset))
+                    memoryOffset += asm[ip][2]
+                    ip = asm[ip][1]
+                elif asm[ip][0] == "LEAVE":
+                    if not returns:
+                        break # Return from main
+                    ip, memoryOffset = returns.pop()
+
+                elif asm[ip][0] == "NOP":
+                    ip += 1
+                else:
+                    print("Unknown instruction: " + asm[ip][0])
+                    break
+            break
+        except IndexError:
+            iter -= 1 # The instruction runs again
+            if profile_file:
+                counts[ip] -= 1
+            if not grow_memory():
+                stack_overflow(ip)
+                break
+else:
+    iter = run_fast()
+elapsed = time.perf_counter() - started
+
+if iter >= max_iter:
+    print("Stopped after %d instructions, see --max-iter" % iter)
+if bench:
+    print("Executed %d instructions in %.3f s, %.0f instructions per second"
+          % (iter, elapsed, iter / elapsed if elapsed > 0 else 0))
 
 if show_memory:
     print("\nMemory at the end:")
-    print(mem)    
+    print(mem[:SHOWN_CELLS])    
+
+
+def write_profile(filename):
+    """
+    Write the profile of the run, one record per line:
+      - B index id line count: executions of a block
+      - J index id line count taken: executions and jumps of a JMF
+      - C index id line count callee: executions of an ENTER
+    """
+    # Ids and source lines of the instructions, 0 if unknown
+    ids = [(0, 0)] * len(asm)
+    fingerprint = None
+    if os.path.exists("asm.map"):
+        for l in open("asm.map", "r").readlines():
+            e = l.split()
+            if len(e) == 4 and e[:2] == ["#", "fingerprint"]:
+                fingerprint = l
+            elif len(e) == 3 and not e[0].startswith("#") and int(e[0]) < len(asm):
+                ids[int(e[0])] = (int(e[1]), int(e[2]))
+
+    # First instruction of each block, as split by the compiler
+    leaders = {0}
+    for i, ins in enumerate(asm):
+        if ins[0] == "JMP" or ins[0] == "ENTER":
+            leaders.add(ins[1])
+        elif ins[0] == "JMF":
+            leaders.add(ins[2])
+        if ins[0] in ("JMP", "JMF", "LEAVE") and i + 1 < len(asm):
+            leaders.add(i + 1)
+
+    with open(filename, "w") as f:
+        f.write("# Profile of asm.txt: B index id line count, J index id line count taken, C index id line count callee\n")
+        if fingerprint:
+            f.write(fingerprint)
+        for i, ins in enumerate(asm):
+            id, line = ids[i]
+            if i in leaders:
+                f.write("B %d %d %d %d\n" % (i, id, line, counts[i]))
+            if ins[0] == "JMF":
+                f.write("J %d %d %d %d %d\n" % (i, id, line, counts[i], taken[i]))
+            elif ins[0] == "ENTER":
+                f.write("C %d %d %d %d %d\n" % (i, id, line, counts[i], ins[1]))
+    print("Profile written to " + filename)
 
+if profile_file:
+    write_profile(profile_file)
@@ -0,0 +1,2467 @@
+/**
+ * @file optimizer.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the optimizations
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "optimizer.h"
+#include <stdio.h>
+#include <limits.h> // INT_MIN, INT_MAX
+#include <stdlib.h> // qsort
+#include <string.h> // memset, memcpy
+#include "cfg.h"
+#include "dataflow.h"
+#include "instructions_table.h"
+#include "functions_table.h"
+#include "profile.h"
+
+/* Control flow graph of the function being optimized */
+static struct_cfg cfg;
+
+/* Loops of the function being optimized */
+static struct_loop loops[CFG_MAX_LOOPS];
+
+/* Liveness of the slots of the function being optimized */
+static struct_liveness liveness;
+
+/**
+ * @brief Number of bits of an integer on the targets
+ *
+ * It is used to get the sign of a value with an arithmetic shift.
+ */
+#define OPT_INT_BITS 32
+
+//
+// HELPERS
+//
+
+/* Check if an instruction only writes its result from its operands */
+static bool opt_is_pure(enum opcode opc) {
+    return opc == iAFC || opc == iCOP || (opc >= iADD && opc <= iOR);
+}
+
+/* Build an instruction replacing another, it_set gives it the id and line of the one it replaces */
+static struct_instruction opt_instruction(enum opcode opc, int op1, int op2, int op3) {
+    return (struct_instruction){.opcode = opc, .op1 = op1, .op2 = op2, .op3 = op3};
+}
+
+/* Check if a slot is tracked by the analyses */
+static bool opt_is_tracked(int slot) {
+    return slot >= 0 && slot < CFG_MAX_SLOTS;
+}
+
+/* Check if an instruction may write a slot */
+static bool opt_writes(int index, int slot) {
+    struct_effects e = it_get_effects(index);
+    for(int d = 0; d < e.nb_defs; d++) {
+        if(e.defs[d] == slot) {
+            return true;
+        }
+    }
+    return e.clobber_from != -1 && slot >= e.clobber_from;
+}
+
+/* Check if an instruction may read a slot */
+static bool opt_reads(int index, int slot) {
+    struct_effects e = it_get_effects(index);
+    for(int u = 0; u < e.nb_uses; u++) {
+        if(e.uses[u] == slot) {
+            return true;
+        }
+    }
+    return e.use_from != -1 && slot >= e.use_from && (e.use_to == -1 || slot < e.use_to);
+}
+
+/* Check if a slot may be written in a loop, except by one instruction */
+static bool opt_written_in_loop(struct_loop* loop, int slot, int except) {
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        if(!loop->body[b]) {
+            continue;
+        }
+        for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+            if(i != except && opt_writes(i, slot)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Add a new slot to the frame of a function
+ *
+ * The new slot is placed below the frame of every call of the function,
+ * so that no call overwrites it. The slots above it are shifted by one,
+ * along with the frames of the calls. The return value and the
+ * parameters never move, so the new slot is above them, and there is
+ * none if the frame of a call starts among them.
+ *
+ * @param start the index of the first instruction of the function
+ * @param end the index after the last instruction of the function
+ * @return int the new slot, -1 if there is none
+ */
+static int opt_new_slot(int start, int end) {
+    int nb_pinned = 1 + ft_get_nb_params(start);
+    int slot = -1;
+    int max = 0;
+    for(int i = start; i < end; i++) {
+        struct_instruction in = it_get(i);
+        int* slots[3];
+        int n = it_get_slot_operands(&in, slots);
+        for(int s = 0; s < n; s++) {
+            if(*slots[s] > max) {
+                max = *slots[s];
+            }
+        }
+        if(in.opcode == iENTER && (slot == -1 || in.op2 < slot)) {
+            slot = in.op2;
+        }
+    }
+    if(slot == -1) {
+        return max + 1 > nb_pinned ? max + 1 : nb_pinned;
+    }
+    if(slot < nb_pinned) {
+        return -1;
+    }
+
+    for(int i = start; i < end; i++) {
+        struct_instruction in = it_get(i);
+        int* slots[3];
+        int n = it_get_slot_operands(&in, slots);
+        for(int s = 0; s < n; s++) {
+            if(*slots[s] >= slot) {
+                (*slots[s])++;
+            }
+        }
+        it_set(i, in);
+    }
+    return slot;
+}
+
+/* Check if a slot may be read after an instruction of a block */
+static bool opt_live_after(int b, int index, int slot) {
+    for(int i = index + 1; i < cfg.blocks[b].end; i++) {
+        if(opt_reads(i, slot)) {
+            return true;
+        }
+        struct_effects e = it_get_effects(i);
+        for(int d = 0; d < e.nb_defs; d++) {
+            if(e.defs[d] == slot) {
+                return false;
+            }
+        }
+    }
+    return bs_test(liveness.live_out[b], slot);
+}
+
+/* Rename the slot read by an instruction, its result is left untouched */
+static void opt_rename_use(int index, int from, int to) {
+    struct_instruction in = it_get(index);
+    int* slots[3];
+    int n = it_get_slot_operands(&in, slots);
+    // The first slot operand is the result, except for JMPF and PRINT
+    int first_use = (in.opcode == iJMPF || in.opcode == iPRINT) ? 0 : 1;
+    for(int s = first_use; s < n; s++) {
+        if(*slots[s] == from) {
+            *slots[s] = to;
+        }
+    }
+    it_set(index, in);
+}
+
+/**
+ * @brief Find the instructions reading the result of an instruction
+ *
+ * The readers are searched in the rest of the block, up to the next
+ * write of the slot. The result escapes if it may be read after the
+ * block, as an argument of a call, by a LEAVE or by a NOT, which also
+ * writes its operand. If keep is not -1, the result also escapes if the
+ * slot keep is written before a reader.
+ *
+ * @param b the block of the instruction
+ * @param index the index of the instruction
+ * @param d the slot of the result
+ * @param keep a slot that must not change before the readers, or -1
+ * @param readers the array of readers to fill
+ * @return int the number of readers, -1 if the result escapes
+ */
+static int opt_find_readers(int b, int index, int d, int keep, int* readers) {
+    int nb_readers = 0;
+    bool keep_written = false;
+    for(int i = index + 1; i < cfg.blocks[b].end; i++) {
+        if(opt_reads(i, d)) {
+            enum opcode opc = it_get(i).opcode;
+            if(opc == iENTER || opc == iLEAVE || opc == iNOT || keep_written) {
+                return -1;
+            }
+            readers[nb_readers++] = i;
+        }
+        if(opt_writes(i, d)) {
+            return nb_readers;
+        }
+        keep_written = keep_written || (keep != -1 && opt_writes(i, keep));
+    }
+    return bs_test(liveness.live_out[b], d) ? -1 : nb_readers;
+}
+
+/**
+ * @brief Find the AFC giving its value to a slot in a block
+ *
+ * @param b the block
+ * @param index the index of the instruction reading the slot
+ * @param slot the slot
+ * @return int the index of the AFC, -1 if the slot is not set by an AFC of the block
+ */
+static int opt_find_afc(int b, int index, int slot) {
+    for(int i = index - 1; i >= cfg.blocks[b].start; i--) {
+        if(opt_writes(i, slot)) {
+            struct_instruction in = it_get(i);
+            return (in.opcode == iAFC && in.op1 == slot) ? i : -1;
+        }
+    }
+    return -1;
+}
+
+/* Get the base 2 logarithm of a power of two, -1 otherwise, in long long so that c - 1 and c + 1 do not overflow */
+static int opt_log2(long long value) {
+    if(value <= 0 || (value & (value - 1)) != 0) {
+        return -1;
+    }
+    int k = 0;
+    while((1LL << k) != value) {
+        k++;
+    }
+    return k;
+}
+
+//
+// SPARSE CONDITIONAL CONSTANT PROPAGATION
+//
+
+/**
+ * @brief Lattice of the values of the slots
+ *
+ * A slot is UNDEFINED while no executed instruction reaches it, CONSTANT
+ * if it always holds the same value, and VARYING otherwise.
+ */
+enum lattice {UNDEFINED, CONSTANT, VARYING};
+
+/* Values of the slots at the start of each block */
+static char lattice_in[CFG_MAX_BLOCKS][CFG_MAX_SLOTS];
+static int constant_in[CFG_MAX_BLOCKS][CFG_MAX_SLOTS];
+
+/* Blocks reached by an executed edge */
+static bool executable[CFG_MAX_BLOCKS];
+
+/* Compute a binary operation on constants like the interpreter, returns false if it cannot */
+static bool opt_fold(enum opcode opc, int a, int b, int* result) {
+    long long r;
+    switch(opc) {
+        case iADD: r = (long long)a + b; break;
+        case iSOU: r = (long long)a - b; break;
+        case iMUL: r = (long long)a * b; break;
+        case iDIV:
+            if(b == 0) {
+                return false; // Left to the program
+            }
+            r = (long long)a / b; // Rounds toward zero
+            break;
+        case iSHL:
+            if(b < 0 || b >= OPT_INT_BITS) {
+                return false;
+            }
+            r = (long long)a * ((long long)1 << b);
+            break;
+        case iSHR:
+            if(b < 0 || b >= OPT_INT_BITS) {
+                return false;
+            }
+            r = a >> b;
+            break;
+        case iBAND: r = a & b; break;
+        case iEQ: r = a == b; break;
+        case iNEQ: r = a != b; break;
+        case iLT: r = a < b; break;
+        case iLE: r = a <= b; break;
+        case iGT: r = a > b; break;
+        case iGE: r = a >= b; break;
+        case iAND: r = a ? b : a; break;
+        case iOR: r = a ? a : b; break;
+        default: return false;
+    }
+    if(r < INT_MIN || r > INT_MAX) {
+        return false;
+    }
+    *result = (int)r;
+    return true;
+}
+
+/* Apply an instruction to the values of the slots */
+static void opt_sccp_transfer(int index, char* kind, int* value) {
+    struct_instruction in = it_get(index);
+    struct_effects e = it_get_effects(index);
+    bool known = false;
+    int result = 0;
+    if(in.opcode == iAFC) {
+        known = true;
+        result = in.op2;
+    } else if(in.opcode == iCOP && opt_is_tracked(in.op2) && kind[in.op2] == CONSTANT) {
+        known = true;
+        result = value[in.op2];
+    } else if(in.opcode == iNOT && opt_is_tracked(in.op1) && kind[in.op1] == CONSTANT) {
+        known = true;
+        result = !value[in.op1];
+    } else if(in.opcode >= iADD && in.opcode <= iOR && opt_is_tracked(in.op2) && opt_is_tracked(in.op3)
+            && kind[in.op2] == CONSTANT && kind[in.op3] == CONSTANT) {
+        known = opt_fold(in.opcode, value[in.op2], value[in.op3], &result);
+    }
+
+    for(int s = e.clobber_from; s >= 0 && s < CFG_MAX_SLOTS; s++) {
+        kind[s] = VARYING;
+    }
+    for(int d = 0; d < e.nb_defs; d++) {
+        if(opt_is_tracked(e.defs[d])) {
+            kind[e.defs[d]] = VARYING;
+        }
+    }
+    if(known && opt_is_tracked(e.defs[0])) {
+        kind[e.defs[0]] = CONSTANT;
+        value[e.defs[0]] = result;
+    }
+}
+
+/* Merge the values at the end of a block into a successor, returns true if they changed */
+static bool opt_sccp_meet(int b, char* kind, int* value) {
+    bool changed = !executable[b];
+    executable[b] = true;
+    for(int s = 0; s < CFG_MAX_SLOTS; s++) {
+        if(kind[s] == UNDEFINED || lattice_in[b][s] == VARYING) {
+            continue;
+        }
+        if(lattice_in[b][s] == UNDEFINED) {
+            lattice_in[b][s] = kind[s];
+            constant_in[b][s] = value[s];
+            changed = true;
+        } else if(kind[s] == VARYING || value[s] != constant_in[b][s]) {
+            lattice_in[b][s] = VARYING;
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+/* Check if a JMPF with a known condition may go to a successor */
+static bool opt_sccp_feasible(int b, int succ, char* kind, int* value) {
+    struct_instruction in = it_get(cfg.blocks[b].end - 1);
+    if(in.opcode != iJMPF || !opt_is_tracked(in.op1) || kind[in.op1] != CONSTANT) {
+        return true;
+    }
+    return value[in.op1] == 0 ? succ == cfg_block_of(&cfg, in.op2) : succ == b + 1;
+}
+
+/**
+ * @brief Propagate the constants over the control flow graph
+ *
+ * The blocks are only visited once an executed edge reaches them: the
+ * JMPF with a known condition only follow one of their edges. Every
+ * slot may hold any value at the entry of the function.
+ */
+static void opt_sccp_analyze() {
+    static int worklist[CFG_MAX_BLOCKS];
+    static bool queued[CFG_MAX_BLOCKS];
+    static char kind[CFG_MAX_SLOTS];
+    static int value[CFG_MAX_SLOTS];
+    int nb_work = 0;
+
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        executable[b] = false;
+        queued[b] = false;
+        memset(lattice_in[b], UNDEFINED, sizeof(lattice_in[b]));
+    }
+    memset(kind, VARYING, sizeof(kind));
+    opt_sccp_meet(0, kind, value);
+    worklist[nb_work++] = 0;
+    queued[0] = true;
+
+    while(nb_work > 0) {
+        int b = worklist[--nb_work];
+        queued[b] = false;
+        memcpy(kind, lattice_in[b], sizeof(kind));
+        memcpy(value, constant_in[b], sizeof(value));
+        for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+            opt_sccp_transfer(i, kind, value);
+        }
+        for(int n = 0; n < cfg.blocks[b].nb_succ; n++) {
+            int succ = cfg.blocks[b].succ[n];
+            if(opt_sccp_feasible(b, succ, kind, value) && opt_sccp_meet(succ, kind, value) && !queued[succ]) {
+                worklist[nb_work++] = succ;
+                queued[succ] = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Constant propagation of a function
+ *
+ * The operations whose result is known become AFC, the JMPF whose
+ * condition is known become a JMP or are removed, and the blocks never
+ * executed are removed. Then the JMP to the next instruction and the
+ * AFC whose result is not live are removed.
+ *
+ * @param function the index of the function in the functions table
+ * @param folded the number of operations folded, updated
+ * @param branches the number of branches folded, updated
+ * @return int the number of removed instructions
+ */
+static int opt_sccp_function(int function, int* folded, int* branches) {
+    static char kind[CFG_MAX_SLOTS];
+    static int value[CFG_MAX_SLOTS];
+    static bool dead[INSTRUCTIONS_TABLE_SIZE];
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    if(cfg.nb_blocks == 0) {
+        return 0;
+    }
+    opt_sccp_analyze();
+
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        struct_block* block = &cfg.blocks[b];
+        for(int i = block->start; i < block->end; i++) {
+            dead[i - start] = !executable[b];
+        }
+        if(!executable[b]) {
+            continue;
+        }
+        memcpy(kind, lattice_in[b], sizeof(kind));
+        memcpy(value, constant_in[b], sizeof(value));
+        for(int i = block->start; i < block->end; i++) {
+            struct_instruction in = it_get(i);
+            if(in.opcode == iJMPF && opt_is_tracked(in.op1) && kind[in.op1] == CONSTANT) {
+                // Always taken or never taken
+                printf("SCCP: JMF at 0x%02x is %s\n", i, value[in.op1] == 0 ? "always taken" : "never taken");
+                if(value[in.op1] == 0) {
+                    it_set(i, opt_instruction(iJMP, in.op2, 0, 0));
+                } else {
+                    dead[i - start] = true;
+                }
+                (*branches)++;
+            }
+            opt_sccp_transfer(i, kind, value);
+            if((opt_is_pure(in.opcode) || in.opcode == iNOT) && in.opcode != iAFC
+                    && opt_is_tracked(in.op1) && kind[in.op1] == CONSTANT) {
+                printf("SCCP: %s at 0x%02x is %d\n", it_get_opcode(in.opcode), i, value[in.op1]);
+                it_set(i, opt_instruction(iAFC, in.op1, value[in.op1], 0));
+                (*folded)++;
+            }
+        }
+    }
+
+    // Remove the dead instructions from the end, but the NOP ending the program
+    int removed = 0;
+    for(int i = end - 1; i >= start; i--) {
+        if(dead[i - start] && i != it_get_index() - 1) {
+            it_remove(i);
+            removed++;
+        }
+    }
+
+    // The folded branches leave jumps to the next instruction, and the
+    // folded conditions constants that nothing reads any more
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    df_liveness(&cfg, &liveness);
+    for(int b = cfg.nb_blocks - 1; b >= 0; b--) {
+        for(int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].start; i--) {
+            struct_instruction in = it_get(i);
+            bool useless = (in.opcode == iJMP && in.op1 == i + 1)
+                || (in.opcode == iAFC && opt_is_tracked(in.op1) && !opt_live_after(b, i, in.op1));
+            if(useless) {
+                printf("SCCP: removing useless %s at 0x%02x\n", it_get_opcode(in.opcode), i);
+                it_remove(i);
+                cfg.blocks[b].end--;
+                removed++;
+            }
+        }
+    }
+    return removed;
+}
+
+/* Sparse conditional constant propagation */
+int opt_sccp() {
+    int folded = 0;
+    int branches = 0;
+    int removed = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        removed += opt_sccp_function(f, &folded, &branches);
+    }
+    printf("SCCP: %d operation(s) and %d branch(es) folded, %d instruction(s) removed\n", folded, branches, removed);
+    return folded + branches + removed;
+}
+
+//
+// STRENGTH REDUCTION
+//
+
+/**
+ * @brief Rewrite a multiplication by a constant
+ *
+ * The constant is in the slot set by the AFC at index afc, which is
+ * only read by the multiplication. It is used as a scratch slot.
+ *
+ * @param index the index of the MUL
+ * @param afc the index of the AFC of the constant
+ * @param x the slot of the other operand
+ * @return true if the multiplication has been rewritten
+ */
+static bool opt_reduce_mul(int index, int afc, int x) {
+    struct_instruction in = it_get(index);
+    int s = it_get(afc).op1;
+    int c = it_get(afc).op2;
+    int d = in.op1;
+    int k;
+
+    if(c == 0 || c == 1 || c == 2) {
+        // x * 0 = 0, x * 1 = x, x * 2 = x + x: the constant is useless
+        if(c == 0) {
+            it_set(index, opt_instruction(iAFC, d, 0, 0));
+        } else if(c == 1) {
+            it_set(index, opt_instruction(iCOP, d, x, 0));
+        } else {
+            it_set(index, opt_instruction(iADD, d, x, x));
+        }
+        it_remove(afc);
+    } else if((k = opt_log2(c)) != -1) {
+        // x * 2^k = x << k
+        it_patch_op2(afc, k);
+        it_set(index, opt_instruction(iSHL, d, x, s));
+    } else if((k = opt_log2((long long)c - 1)) != -1) {
+        // x * (2^k + 1) = (x << k) + x
+        it_patch_op2(afc, k);
+        it_set(index, opt_instruction(iSHL, s, x, s));
+        it_insert_at(index + 1, iADD, d, s, x);
+    } else if((k = opt_log2((long long)c + 1)) != -1) {
+        // x * (2^k - 1) = (x << k) - x
+        it_patch_op2(afc, k);
+        it_set(index, opt_instruction(iSHL, s, x, s));
+        it_insert_at(index + 1, iSOU, d, s, x);
+    } else {
+        return false;
+    }
+    printf("Strength reduction: MUL by %d at 0x%02x\n", c, index);
+    return true;
+}
+
+/**
+ * @brief Rewrite a division by a power of two
+ *
+ * The division rounds toward zero, while an arithmetic shift rounds
+ * down. A negative dividend is thus biased by 2^k - 1 before the shift:
+ * bias = (x >> (bits - 1)) & (2^k - 1), result = (x + bias) >> k.
+ *
+ * @param index the index of the DIV
+ * @param afc the index of the AFC of the divisor, only read by the DIV
+ * @return true if the division has been rewritten
+ */
+static bool opt_reduce_div(int index, int afc) {
+    int c = it_get(afc).op2;
+    int k = opt_log2(c);
+    if(k == -1) {
+        return false;
+    }
+    if(c == 1) {
+        struct_instruction in = it_get(index);
+        it_set(index, opt_instruction(iCOP, in.op1, in.op2, 0));
+        it_remove(afc);
+        printf("Strength reduction: DIV by %d at 0x%02x\n", c, index);
+        return true;
+    }
+
+    // A second scratch slot is needed: the result, unless it is an operand
+    int t = it_get(index).op1;
+    if(t == it_get(index).op2 || t == it_get(index).op3) {
+        t = opt_new_slot(cfg.start, cfg.end);
+        if(!opt_is_tracked(t)) {
+            return false;
+        }
+    }
+    struct_instruction in = it_get(index);
+    int s = it_get(afc).op1;
+    int d = in.op1;
+    int x = in.op2;
+
+    it_patch_op2(afc, OPT_INT_BITS - 1);
+    it_set(index, opt_instruction(iSHR, s, x, s));     // s = x < 0 ? -1 : 0
+    it_insert_at(index + 1, iAFC, t, c - 1, 0);
+    it_insert_at(index + 2, iBAND, s, s, t);                // s = bias
+    it_insert_at(index + 3, iADD, s, x, s);
+    it_insert_at(index + 4, iAFC, t, k, 0);
+    it_insert_at(index + 5, iSHR, d, s, t);
+    printf("Strength reduction: DIV by %d at 0x%02x\n", c, index);
+    return true;
+}
+
+/* Rewrite one multiplication or division of a function */
+static bool opt_strength_reduction_function(int function) {
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    df_liveness(&cfg, &liveness);
+
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+            struct_instruction in = it_get(i);
+            if(in.opcode != iMUL && in.opcode != iDIV) {
+                continue;
+            }
+            // Only the second operand of a division, any operand of a multiplication
+            for(int o = (in.opcode == iDIV ? 3 : 2); o <= 3; o++) {
+                int s = o == 2 ? in.op2 : in.op3;
+                int x = o == 2 ? in.op3 : in.op2;
+                int afc = opt_find_afc(b, i, s);
+                if(s == x || !opt_is_tracked(s) || afc == -1) {
+                    continue;
+                }
+                // The slot of the constant is used as a scratch slot
+                bool scratch = s == in.op1 || !opt_live_after(b, i, s);
+                for(int j = afc + 1; j < i; j++) {
+                    scratch = scratch && !opt_reads(j, s);
+                }
+                if(!scratch) {
+                    continue;
+                }
+                if(in.opcode == iMUL ? opt_reduce_mul(i, afc, x) : opt_reduce_div(i, afc)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/* Strength reduction */
+int opt_strength_reduction() {
+    int reduced = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        while(opt_strength_reduction_function(f)) {
+            reduced++;
+        }
+    }
+    printf("Strength reduction: %d instruction(s) reduced\n", reduced);
+    return reduced;
+}
+
+//
+// LOCAL VALUE NUMBERING
+//
+
+/**
+ * @brief Structure for a value computed in a block
+ *
+ * A value is identified by the operation that computes it and the
+ * values of its operands. For an AFC, the first operand is the constant.
+ *
+ * @param opcode the opcode of the operation
+ * @param a the value of the first operand, or the constant
+ * @param b the value of the second operand
+ * @param value the value number of the result
+ */
+typedef struct {
+    int opcode;
+    int a;
+    int b;
+    int value;
+} struct_value;
+
+/* Values computed in the current block */
+static struct_value values[INSTRUCTIONS_TABLE_SIZE];
+static int nb_values;
+
+/* Value number held by each slot */
+static int slot_value[CFG_MAX_SLOTS];
+static int next_value;
+
+/* Check if the operands of an operation can be swapped */
+static bool opt_is_commutative(enum opcode opc) {
+    return opc == iADD || opc == iMUL || opc == iEQ || opc == iNEQ
+        || opc == iAND || opc == iOR || opc == iBAND;
+}
+
+/* Find or add the value computed by an operation */
+static int opt_value_of(int opcode, int a, int b, bool* found) {
+    if(opt_is_commutative(opcode) && a > b) {
+        int tmp = a; a = b; b = tmp;
+    }
+    for(int v = 0; v < nb_values; v++) {
+        if(values[v].opcode == opcode && values[v].a == a && values[v].b == b) {
+            *found = true;
+            return values[v].value;
+        }
+    }
+    *found = false;
+    values[nb_values++] = (struct_value){opcode, a, b, next_value};
+    return next_value++;
+}
+
+/* Forget the values held by the slots written by an instruction */
+static void opt_kill_values(int index) {
+    struct_effects e = it_get_effects(index);
+    for(int d = 0; d < e.nb_defs; d++) {
+        if(opt_is_tracked(e.defs[d])) {
+            slot_value[e.defs[d]] = next_value++;
+        }
+    }
+    for(int s = e.clobber_from; s >= 0 && s < CFG_MAX_SLOTS; s++) {
+        slot_value[s] = next_value++;
+    }
+}
+
+/**
+ * @brief Number the values of a block and remove the redundant ones
+ *
+ * @param b the block
+ * @param copies the number of operations replaced by a copy, updated
+ * @return int the number of removed instructions
+ */
+static int opt_value_numbering_block(int b, int* copies) {
+    static int readers[INSTRUCTIONS_TABLE_SIZE];
+    int removed = 0;
+
+    // Every slot holds an unknown value at the start of the block
+    nb_values = 0;
+    next_value = 0;
+    for(int s = 0; s < CFG_MAX_SLOTS; s++) {
+        slot_value[s] = next_value++;
+    }
+
+    for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+        struct_instruction in = it_get(i);
+        int d = in.op1;
+        bool pure = in.opcode == iAFC || (in.opcode >= iADD && in.opcode <= iOR);
+        bool tracked = opt_is_tracked(d)
+            && (in.opcode == iAFC || (opt_is_tracked(in.op2) && opt_is_tracked(in.op3)));
+
+        if(in.opcode == iCOP && opt_is_tracked(d) && opt_is_tracked(in.op2)) {
+            // A copy gives the same value to its result
+            if(slot_value[d] == slot_value[in.op2]) {
+                printf("LVN: removing copy at 0x%02x\n", i);
+                it_remove(i--);
+                cfg.blocks[b].end--;
+                removed++;
+            } else {
+                slot_value[d] = slot_value[in.op2];
+            }
+            continue;
+        }
+        if(!pure || !tracked) {
+            opt_kill_values(i);
+            continue;
+        }
+
+        bool found;
+        int v = in.opcode == iAFC
+            ? opt_value_of(iAFC, in.op2, 0, &found)
+            : opt_value_of(in.opcode, slot_value[in.op2], slot_value[in.op3], &found);
+        if(found && slot_value[d] == v) {
+            // The result already holds the value
+            printf("LVN: removing %s at 0x%02x\n", it_get_opcode(in.opcode), i);
+            it_remove(i--);
+            cfg.blocks[b].end--;
+            removed++;
+            continue;
+        }
+        int h = -1;
+        for(int s = 0; found && h == -1 && s < CFG_MAX_SLOTS; s++) {
+            if(slot_value[s] == v) {
+                h = s;
+            }
+        }
+        if(h != -1) {
+            int nb_readers = opt_find_readers(b, i, d, h, readers);
+            if(nb_readers >= 0) {
+                // The readers read the value where it already is
+                printf("LVN: removing %s at 0x%02x, reusing slot %d\n", it_get_opcode(in.opcode), i, h);
+                for(int r = 0; r < nb_readers; r++) {
+                    opt_rename_use(readers[r], d, h);
+                }
+                it_remove(i--);
+                cfg.blocks[b].end--;
+                removed++;
+                continue;
+            }
+            if(in.opcode != iAFC) {
+                // A constant is kept, it is cheaper than a copy in the registers
+                printf("LVN: replacing %s at 0x%02x by a copy of slot %d\n", it_get_opcode(in.opcode), i, h);
+                it_set(i, opt_instruction(iCOP, d, h, 0));
+                (*copies)++;
+            }
+        }
+        slot_value[d] = v;
+    }
+    return removed;
+}
+
+/* Local value numbering */
+int opt_value_numbering() {
+    int removed = 0;
+    int copies = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        int start, end;
+        cfg_get_function_range(f, &start, &end);
+        cfg_build(&cfg, start, end);
+        df_liveness(&cfg, &liveness);
+        // Last block first, so that the removals do not move the blocks left to do
+        for(int b = cfg.nb_blocks - 1; b >= 0; b--) {
+            removed += opt_value_numbering_block(b, &copies);
+        }
+    }
+    printf("LVN: %d instruction(s) removed, %d replaced by a copy\n", removed, copies);
+    return removed + copies;
+}
+
+//
+// LOOP-INVARIANT CODE MOTION
+//
+
+/**
+ * @brief Move an instruction of a loop to its preheader
+ *
+ * The instruction is removed from the loop and inserted before the
+ * header. The jumps from outside the loop to the header now reach the
+ * preheader, the jumps of the loop back to the header are patched.
+ *
+ * @param loop the loop
+ * @param index the index of the instruction
+ * @param instruction the instruction to insert in the preheader
+ */
+static void opt_move_to_preheader(struct_loop* loop, int index, struct_instruction instruction) {
+    static int back_jumps[INSTRUCTIONS_TABLE_SIZE];
+    int nb_back_jumps = 0;
+    int header = cfg.blocks[loop->header].start;
+
+    // Jumps of the loop back to the header
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        int last = cfg.blocks[b].end - 1;
+        if(loop->body[b] && last != index && it_get_target(last) == header
+                && it_get(last).opcode != iENTER) {
+            back_jumps[nb_back_jumps++] = last > index ? last - 1 : last;
+        }
+    }
+
+    it_remove(index);
+    if(index < header) {
+        header--;
+    }
+    it_insert_at(header, instruction.opcode, instruction.op1, instruction.op2, instruction.op3);
+    for(int j = 0; j < nb_back_jumps; j++) {
+        int jump = back_jumps[j] >= header ? back_jumps[j] + 1 : back_jumps[j];
+        it_set_target(jump, header + 1);
+    }
+}
+
+/**
+ * @brief Try to hoist an instruction out of a loop
+ *
+ * @param loop the loop
+ * @param b the block of the instruction
+ * @param index the index of the instruction
+ * @return true if the instruction has been hoisted
+ */
+static bool opt_licm_instruction(struct_loop* loop, int b, int index) {
+    struct_instruction in = it_get(index);
+    if(!opt_is_pure(in.opcode)) {
+        return false;
+    }
+
+    // The operands must not change in the loop
+    struct_effects e = it_get_effects(index);
+    int d = e.defs[0];
+    if(!opt_is_tracked(d)) {
+        return false;
+    }
+    for(int u = 0; u < e.nb_uses; u++) {
+        if(!opt_is_tracked(e.uses[u]) || opt_written_in_loop(loop, e.uses[u], -1)) {
+            return false;
+        }
+    }
+
+    // Is the instruction executed before every exit of the loop?
+    bool always = true;
+    bool live_after = false;
+    for(int x = 0; x < cfg.nb_blocks; x++) {
+        if(!loop->body[x]) {
+            continue;
+        }
+        for(int s = 0; s < cfg.blocks[x].nb_succ; s++) {
+            int y = cfg.blocks[x].succ[s];
+            if(!loop->body[y]) {
+                always = always && cfg_dominates(&cfg, b, x);
+                live_after = live_after || bs_test(liveness.live_in[y], d);
+            }
+        }
+    }
+    if(in.opcode == iDIV && !always) {
+        return false; // Could divide by zero when the loop is not executed
+    }
+
+    // Hoist the instruction as is
+    if(!opt_written_in_loop(loop, d, index) && !bs_test(liveness.live_in[loop->header], d)
+            && (always || !live_after)) {
+        printf("LICM: hoisting instruction 0x%02x %s\n", index, it_get_opcode(in.opcode));
+        opt_move_to_preheader(loop, index, in);
+        return true;
+    }
+
+    // Otherwise, the result must only be read by the end of the block
+    static int readers[INSTRUCTIONS_TABLE_SIZE];
+    int nb_readers = opt_find_readers(b, index, d, -1, readers);
+    if(nb_readers <= 0) {
+        return false;
+    }
+
+    // Hoist the instruction into a new slot read by the readers
+    int slot = opt_new_slot(cfg.start, cfg.end);
+    if(!opt_is_tracked(slot)) {
+        return false;
+    }
+    printf("LICM: hoisting instruction 0x%02x %s into slot %d\n", index, it_get_opcode(in.opcode), slot);
+    d = d >= slot ? d + 1 : d;
+    for(int r = 0; r < nb_readers; r++) {
+        opt_rename_use(readers[r], d, slot);
+    }
+    in = it_get(index);
+    in.op1 = slot;
+    opt_move_to_preheader(loop, index, in);
+    return true;
+}
+
+/* Hoist one instruction out of a loop of a function */
+static bool opt_licm_function(int function) {
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    int nb_loops = cfg_find_loops(&cfg, loops);
+    if(nb_loops == 0) {
+        return false;
+    }
+    df_liveness(&cfg, &liveness);
+
+    for(int l = 0; l < nb_loops; l++) {
+        // The preheader is placed before the header, which must
+        // not be reached by falling through from the loop
+        int h = loops[l].header;
+        if(h > 0 && loops[l].body[h-1] && cfg.blocks[h-1].nb_succ > 0
+                && it_get(cfg.blocks[h-1].end - 1).opcode != iJMP) {
+            continue;
+        }
+        for(int b = 0; b < cfg.nb_blocks; b++) {
+            if(!loops[l].body[b]) {
+                continue;
+            }
+            for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+                if(opt_licm_instruction(&loops[l], b, i)) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/* Loop-invariant code motion */
+int opt_licm() {
+    int hoisted = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        while(opt_licm_function(f)) {
+            hoisted++;
+        }
+    }
+    printf("LICM: %d instruction(s) hoisted\n", hoisted);
+    return hoisted;
+}
+
+//
+// LOOP UNROLLING
+//
+
+/* Instructions replacing the loop being unrolled */
+static struct_instruction unrolled[INSTRUCTIONS_TABLE_SIZE];
+static int nb_unrolled;
+
+/* Get the value of a slot when a loop is entered, returns false if it is not constant */
+static bool opt_entry_value(struct_loop* loop, int slot, int* result) {
+    static char kind[CFG_MAX_SLOTS];
+    static int value[CFG_MAX_SLOTS];
+    bool found = false;
+    for(int p = 0; p < cfg.nb_blocks; p++) {
+        if(loop->body[p] || !executable[p]) {
+            continue;
+        }
+        for(int s = 0; s < cfg.blocks[p].nb_succ; s++) {
+            if(cfg.blocks[p].succ[s] != loop->header) {
+                continue;
+            }
+            memcpy(kind, lattice_in[p], sizeof(kind));
+            memcpy(value, constant_in[p], sizeof(value));
+            for(int i = cfg.blocks[p].start; i < cfg.blocks[p].end; i++) {
+                opt_sccp_transfer(i, kind, value);
+            }
+            if(kind[slot] != CONSTANT || (found && value[slot] != *result)) {
+                return false;
+            }
+            *result = value[slot];
+            found = true;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Find the update of an induction variable of a single block loop
+ *
+ * The slot must be written once in the loop, by an ADD or a SOU of itself
+ * and of a slot holding a constant: an AFC before the update in the
+ * block, or a constant at the entry of the loop not written in the loop.
+ *
+ * @param loop the loop
+ * @param slot the slot of the induction variable
+ * @param step the value added to the slot at each iteration, filled
+ * @return int the index of the update, -1 if the slot is not an induction variable
+ */
+static int opt_find_induction(struct_loop* loop, int slot, int* step) {
+    struct_block* block = &cfg.blocks[loop->header];
+    int update = -1;
+    for(int i = block->start; i < block->end; i++) {
+        if(opt_writes(i, slot)) {
+            if(update != -1) {
+                return -1;
+            }
+            update = i;
+        }
+    }
+    if(update == -1) {
+        return -1;
+    }
+
+    struct_instruction in = it_get(update);
+    int k;
+    if(in.opcode == iADD && in.op1 == slot && in.op2 == slot && in.op3 != slot) {
+        k = in.op3;
+    } else if((in.opcode == iADD || in.opcode == iSOU) && in.op1 == slot && in.op3 == slot && in.op2 != slot) {
+        k = in.op2;
+        if(in.opcode == iSOU) {
+            return -1; // k - i is not an induction variable
+        }
+    } else if(in.opcode == iSOU && in.op1 == slot && in.op2 == slot && in.op3 != slot) {
+        k = in.op3;
+    } else {
+        return -1;
+    }
+    if(!opt_is_tracked(k)) {
+        return -1;
+    }
+
+    int afc = opt_find_afc(loop->header, update, k);
+    if(afc != -1) {
+        *step = it_get(afc).op2;
+    } else if(opt_written_in_loop(loop, k, -1) || !opt_entry_value(loop, k, step)) {
+        return -1;
+    }
+    if(in.opcode == iSOU) {
+        if(*step == INT_MIN) {
+            return -1;
+        }
+        *step = -*step;
+    }
+    return *step != 0 ? update : -1;
+}
+
+/* Comparison of the operands in the other order */
+static enum opcode opt_swap_comparison(enum opcode opc) {
+    switch(opc) {
+        case iLT: return iGT;
+        case iGT: return iLT;
+        case iLE: return iGE;
+        default: return iLE;
+    }
+}
+
+/* Opposite comparison */
+static enum opcode opt_invert_comparison(enum opcode opc) {
+    switch(opc) {
+        case iLT: return iGE;
+        case iGE: return iLT;
+        case iGT: return iLE;
+        case iEQ: return iNEQ;
+        case iNEQ: return iEQ;
+        default: return iGT;
+    }
+}
+
+/**
+ * @brief Count the iterations of a loop from the constant entry values
+ *
+ * The body is executed once, then again while the induction variable,
+ * updated by the step, still compares to the bound with the opcode.
+ *
+ * @return long long the number of iterations, -1 if a value overflows
+ */
+static long long opt_trip_count(enum opcode cont, long long first, long long bound, long long step) {
+    long long a = first + step;
+    long long n;
+    switch(cont) {
+        case iLT: n = a >= bound ? 0 : (bound - a + step - 1) / step; break;
+        case iLE: n = a > bound ? 0 : (bound - a) / step + 1; break;
+        case iGT: n = a <= bound ? 0 : (a - bound - step - 1) / -step; break;
+        default: n = a < bound ? 0 : (a - bound) / -step + 1; break;
+    }
+    long long last = first + (n + 1) * step;
+    if(last < INT_MIN || last > INT_MAX) {
+        return -1;
+    }
+    return n + 1;
+}
+
+/* Append the body of a loop, without its exit test, to the unrolled instructions */
+static void opt_unroll_body(struct_block* block, int copies) {
+    for(int c = 0; c < copies; c++) {
+        for(int i = block->start; i < block->end - 2; i++) {
+            unrolled[nb_unrolled++] = it_get(i);
+        }
+    }
+}
+
+/* Append an instruction of the exit tests to the unrolled instructions, returns its index */
+static int opt_unroll_emit(int start, struct_instruction origin, enum opcode opc, int op1, int op2, int op3) {
+    // Tagged as a copy of the instruction it comes from, for the profile
+    unrolled[nb_unrolled] = (struct_instruction){opc, op1, op2, op3, origin.id, origin.line};
+    return start + nb_unrolled++;
+}
+
+/**
+ * @brief Replace the instructions of a block by the unrolled instructions
+ *
+ * The jumps to the start of the block still reach it, the jumps after
+ * the block follow it. The jumps of the unrolled instructions already
+ * target their final index.
+ *
+ * @param block the block
+ */
+static void opt_replace_block(struct_block* block) {
+    int size = block->end - block->start;
+    // Insert and remove inside the block, so that its start does not move
+    for(; size < nb_unrolled; size++) {
+        it_insert_at(block->start + 1, iNOP, 0, 0, 0);
+    }
+    for(; size > nb_unrolled; size--) {
+        it_remove(block->start + 1);
+    }
+    for(int i = 0; i < nb_unrolled; i++) {
+        // The copied calls follow the functions moved by the new size
+        if(unrolled[i].opcode == iENTER && unrolled[i].op1 > block->start) {
+            unrolled[i].op1 += nb_unrolled - (block->end - block->start);
+        }
+        it_set(block->start + i, unrolled[i]);
+    }
+}
+
+/**
+ * @brief Unroll a loop made of a single block
+ *
+ * The block must end with a comparison of an induction variable with a
+ * bound not written in the loop, and a JMPF back to the start of the
+ * block while the comparison is false, as generated for a while loop.
+ *
+ * @param loop the loop
+ * @param factor the number of copies of the body of an unrolled loop
+ * @return true if the loop has been unrolled
+ */
+static bool opt_unroll_loop(struct_loop* loop, int factor) {
+    struct_block* block = &cfg.blocks[loop->header];
+    int start = block->start;
+    if(loop->nb_blocks != 1) {
+        printf("Unrolling: loop at 0x%02x not unrolled, its body has branches\n", start);
+        return false;
+    }
+
+    // Exit test: comparison c x y, JMF c start
+    struct_instruction jump = it_get(block->end - 1);
+    struct_instruction test = it_get(block->end - 2);
+    int c = jump.op1;
+    if(block->end - block->start < 3 || jump.opcode != iJMPF || test.op1 != c
+            || test.opcode < iLT || test.opcode > iGE || !opt_is_tracked(c)) {
+        printf("Unrolling: loop at 0x%02x not unrolled, its exit test is not a comparison\n", start);
+        return false;
+    }
+    // The exit test is used as a scratch slot by the unrolled loop
+    int exit = cfg_block_of(&cfg, block->end);
+    if(exit == -1 || bs_test(liveness.live_in[exit], c) || bs_test(liveness.live_in[loop->header], c)) {
+        printf("Unrolling: loop at 0x%02x not unrolled, its exit test is read elsewhere\n", start);
+        return false;
+    }
+
+    // The loop goes on while cont(i, n) holds, the induction variable i
+    // moving toward the bound n
+    int step;
+    int i = test.op2, n = test.op3;
+    enum opcode cont = opt_invert_comparison(test.opcode);
+    if(opt_find_induction(loop, i, &step) == -1) {
+        i = test.op3;
+        n = test.op2;
+        cont = opt_swap_comparison(cont);
+        if(opt_find_induction(loop, i, &step) == -1) {
+            printf("Unrolling: loop at 0x%02x not unrolled, no induction variable with a constant step\n", start);
+            return false;
+        }
+    }
+    if(i == n || c == i || c == n || !opt_is_tracked(n) || opt_written_in_loop(loop, n, -1)) {
+        printf("Unrolling: loop at 0x%02x not unrolled, its bound changes in the loop\n", start);
+        return false;
+    }
+    if((step > 0) != (cont == iLT || cont == iLE)) {
+        printf("Unrolling: loop at 0x%02x not unrolled, its step goes away from the bound\n", start);
+        return false;
+    }
+
+    // The profile tells how many times the loop iterates: the JMPF jumps
+    // back at each iteration but the last one
+    int executed, taken;
+    if(pf_branch(block->end - 1, &executed, &taken)) {
+        int entries = executed - taken;
+        if(entries <= 0) {
+            printf("Unrolling: loop at 0x%02x not unrolled, it did not run in the profile\n", start);
+            return false;
+        }
+        int average = executed / entries;
+        if(average < 2) {
+            printf("Unrolling: loop at 0x%02x not unrolled, %d iteration(s) on average in the profile\n", start, average);
+            return false;
+        }
+        if(factor > average) {
+            factor = average;
+        }
+    }
+
+    // Constant trip count: unroll fully if small enough
+    int size = block->end - block->start - 2;
+    int first, bound;
+    long long trips = -1;
+    if(opt_entry_value(loop, i, &first) && opt_entry_value(loop, n, &bound)) {
+        trips = opt_trip_count(cont, first, bound, step);
+    }
+    nb_unrolled = 0;
+    if(trips != -1 && trips * size <= UNROLL_MAX_SIZE) {
+        opt_unroll_body(block, (int)trips);
+        printf("Unrolling: loop at 0x%02x fully unrolled, %lld iteration(s) from constants\n", start, trips);
+    } else {
+        while(factor > 2 && factor * size > UNROLL_MAX_SIZE) {
+            factor--;
+        }
+        if(factor < 2 || factor * size > UNROLL_MAX_SIZE) {
+            printf("Unrolling: loop at 0x%02x not unrolled, its body is too large\n", start);
+            return false;
+        }
+
+        if(trips != -1) {
+            // Peel the extra iterations, then test every factor iterations
+            int peeled = (int)(trips % factor);
+            opt_unroll_body(block, peeled);
+            int body = start + nb_unrolled;
+            opt_unroll_body(block, factor);
+            opt_unroll_emit(start, test, test.opcode, test.op1, test.op2, test.op3);
+            opt_unroll_emit(start, jump, iJMPF, c, body, 0);
+            printf("Unrolling: loop at 0x%02x unrolled by %d, %d iteration(s) peeled from %lld\n",
+                start, factor, peeled, trips);
+        } else {
+            // Run factor iterations at once while i + (factor-1)*step
+            // still compares to n, then the rest with the original loop
+            int ahead = (factor - 1) * step;
+            opt_unroll_emit(start, test, iAFC, c, ahead, 0);
+            opt_unroll_emit(start, test, iADD, c, i, c);
+            opt_unroll_emit(start, test, cont, c, c, n);
+            int guard = opt_unroll_emit(start, jump, iJMPF, c, -1, 0);
+            int body = start + nb_unrolled;
+            opt_unroll_body(block, factor);
+            opt_unroll_emit(start, test, iAFC, c, ahead, 0);
+            opt_unroll_emit(start, test, iADD, c, i, c);
+            opt_unroll_emit(start, test, opt_invert_comparison(cont), c, c, n);
+            opt_unroll_emit(start, jump, iJMPF, c, body, 0);
+            opt_unroll_emit(start, test, cont, c, i, n);
+            int remainder = opt_unroll_emit(start, jump, iJMPF, c, -1, 0);
+            int loop_start = start + nb_unrolled;
+            opt_unroll_body(block, 1);
+            opt_unroll_emit(start, test, test.opcode, test.op1, test.op2, test.op3);
+            int after = opt_unroll_emit(start, jump, iJMPF, c, loop_start, 0) + 1;
+            unrolled[guard - start].op2 = loop_start;
+            unrolled[remainder - start].op2 = after;
+            printf("Unrolling: loop at 0x%02x unrolled by %d with a remainder loop, step %d\n", start, factor, step);
+        }
+    }
+    if(it_get_index() + nb_unrolled - (size + 2) > INSTRUCTIONS_TABLE_SIZE) {
+        printf("Unrolling: loop at 0x%02x not unrolled, the instructions table is full\n", start);
+        return false;
+    }
+    opt_replace_block(block);
+    return true;
+}
+
+/* Unroll the loops of a function, returns the number of unrolled loops */
+static int opt_unroll_function(int function, int factor) {
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    int nb_loops = cfg_find_loops(&cfg, loops);
+    if(nb_loops == 0) {
+        return 0;
+    }
+    df_liveness(&cfg, &liveness);
+    opt_sccp_analyze();
+
+    // Last loop first, so that the changes do not move the loops left to do
+    int unrolled_loops = 0;
+    for(int b = cfg.nb_blocks - 1; b >= 0; b--) {
+        for(int l = 0; l < nb_loops; l++) {
+            if(loops[l].header == b && executable[b]) {
+                unrolled_loops += opt_unroll_loop(&loops[l], factor);
+            }
+        }
+    }
+    return unrolled_loops;
+}
+
+/* Loop unrolling */
+int opt_unroll(int factor) {
+    int unrolled_loops = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        unrolled_loops += opt_unroll_function(f, factor);
+    }
+    printf("Unrolling: %d loop(s) unrolled\n", unrolled_loops);
+    return unrolled_loops;
+}
+
+//
+// SETHI-ULLMAN ORDERING
+//
+
+/**
+ * @brief Structure for a node of an expression tree
+ *
+ * A node is an AFC or a binary operation. The operand of a node is a
+ * child node if it is computed in the same block and only read by the
+ * node, otherwise it is a leaf, like a variable.
+ *
+ * @param index the index of the instruction
+ * @param child the nodes of the two operands, -1 for a leaf
+ * @param need the number of temporary variables needed to compute the node
+ * @param swap true if the second operand is computed first
+ */
+typedef struct {
+    int index;
+    int child[2];
+    int need;
+    bool swap;
+} struct_node;
+
+/* Nodes of the expression tree being ordered, the root is the first one */
+static struct_node nodes[INSTRUCTIONS_TABLE_SIZE];
+static int nb_nodes;
+
+/* Instructions already in an expression tree of the function */
+static bool in_tree[INSTRUCTIONS_TABLE_SIZE];
+
+/* Check if an instruction can be a node of an expression tree */
+static bool opt_is_node(enum opcode opc) {
+    return opc == iAFC || (opc >= iADD && opc <= iOR);
+}
+
+/**
+ * @brief Build the expression tree of an instruction
+ *
+ * The nodes are labeled with the number of temporary variables they
+ * need (Sethi-Ullman): the operand needing more temporary variables is
+ * computed first, as the result of the other one is held meanwhile.
+ *
+ * @param b the block of the instruction
+ * @param index the index of the instruction
+ * @return int the node of the instruction
+ */
+static int opt_build_tree(int b, int index) {
+    static int readers[INSTRUCTIONS_TABLE_SIZE];
+    int node = nb_nodes++;
+    struct_instruction in = it_get(index);
+    nodes[node] = (struct_node){index, {-1, -1}, 1, false};
+    in_tree[index - cfg.start] = true;
+    if(in.opcode == iAFC) {
+        return node;
+    }
+
+    int operands[2] = {in.op2, in.op3};
+    for(int o = 0; o < 2; o++) {
+        int s = operands[o];
+        if(operands[0] == operands[1] || !opt_is_tracked(s)) {
+            continue;
+        }
+        int def = index - 1;
+        while(def >= cfg.blocks[b].start && !opt_writes(def, s)) {
+            def--;
+        }
+        if(def < cfg.blocks[b].start || in_tree[def - cfg.start] || !opt_is_node(it_get(def).opcode)
+                || opt_find_readers(b, def, s, -1, readers) != 1 || readers[0] != index) {
+            continue;
+        }
+        nodes[node].child[o] = opt_build_tree(b, def);
+    }
+
+    // The result of the first operand computed is held while computing the other one
+    int need[2], held[2];
+    for(int o = 0; o < 2; o++) {
+        need[o] = nodes[node].child[o] == -1 ? 0 : nodes[nodes[node].child[o]].need;
+        held[o] = nodes[node].child[o] == -1 ? 0 : 1;
+    }
+    int in_order = need[0] > held[0] + need[1] ? need[0] : held[0] + need[1];
+    int swapped = need[1] > held[1] + need[0] ? need[1] : held[1] + need[0];
+    nodes[node].swap = swapped < in_order;
+    nodes[node].need = nodes[node].swap ? swapped : in_order;
+    if(nodes[node].need < 1) {
+        nodes[node].need = 1;
+    }
+    return node;
+}
+
+/* Get the nodes of a tree in the order of the labels */
+static void opt_tree_order(int node, int* order, int* nb_order) {
+    for(int k = 0; k < 2; k++) {
+        int c = nodes[node].child[nodes[node].swap ? 1 - k : k];
+        if(c != -1) {
+            opt_tree_order(c, order, nb_order);
+        }
+    }
+    order[(*nb_order)++] = node;
+}
+
+/**
+ * @brief Give a temporary variable to each node of a tree
+ *
+ * The nodes are computed in the given order, the root last. The result
+ * of a node takes the lowest free slot of the pool, and frees the slots
+ * of its operands.
+ *
+ * @param order the nodes in the order of computation
+ * @param nb_pool the number of slots of the pool
+ * @param slot_of the slot given to each node, as an index in the pool
+ * @return int the maximum number of temporary variables held at once, -1 if the pool is too small
+ */
+static int opt_assign_temps(int* order, int nb_pool, int* slot_of) {
+    static bool busy[INSTRUCTIONS_TABLE_SIZE];
+    memset(busy, 0, sizeof(bool) * nb_pool);
+    int held = 0;
+    int peak = 0;
+    for(int k = 0; k < nb_nodes - 1; k++) {
+        int n = order[k];
+        for(int o = 0; o < 2; o++) {
+            if(nodes[n].child[o] != -1) {
+                busy[slot_of[nodes[n].child[o]]] = false;
+                held--;
+            }
+        }
+        int p = 0;
+        while(p < nb_pool && busy[p]) {
+            p++;
+        }
+        if(p == nb_pool) {
+            return -1;
+        }
+        busy[p] = true;
+        slot_of[n] = p;
+        held++;
+        peak = held > peak ? held : peak;
+    }
+    return peak;
+}
+
+/**
+ * @brief Compute an expression tree in the order of its labels
+ *
+ * The tree must be made of consecutive instructions, and its nodes must
+ * not write a leaf. The temporary variables of the tree are given again
+ * from the slots they used, so that fewer of them are held at once.
+ *
+ * @return int the number of temporary variables saved
+ */
+static int opt_order_tree() {
+    static int order[INSTRUCTIONS_TABLE_SIZE];
+    static int original[INSTRUCTIONS_TABLE_SIZE];
+    static int pool[INSTRUCTIONS_TABLE_SIZE];
+    static int slot_of[INSTRUCTIONS_TABLE_SIZE];
+    static struct_instruction instructions[INSTRUCTIONS_TABLE_SIZE];
+    int root = nodes[0].index;
+
+    // The nodes in the order of the instructions, which must be consecutive
+    int first = root;
+    for(int n = 0; n < nb_nodes; n++) {
+        first = nodes[n].index < first ? nodes[n].index : first;
+    }
+    if(root - first + 1 != nb_nodes) {
+        return 0;
+    }
+    for(int n = 0; n < nb_nodes; n++) {
+        original[nodes[n].index - first] = n;
+    }
+
+    // The pool of temporary variables, which must not be leaves
+    int nb_pool = 0;
+    for(int n = 1; n < nb_nodes; n++) {
+        int slot = it_get(nodes[n].index).op1;
+        int p = 0;
+        while(p < nb_pool && pool[p] != slot) {
+            p++;
+        }
+        if(p == nb_pool) {
+            int q = nb_pool++;
+            for(; q > 0 && pool[q-1] > slot; q--) {
+                pool[q] = pool[q-1];
+            }
+            pool[q] = slot;
+        }
+    }
+    for(int n = 0; n < nb_nodes; n++) {
+        struct_instruction in = it_get(nodes[n].index);
+        int operands[2] = {in.op2, in.op3};
+        for(int o = 0; in.opcode != iAFC && o < 2; o++) {
+            for(int p = 0; nodes[n].child[o] == -1 && p < nb_pool; p++) {
+                if(pool[p] == operands[o]) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    int nb_order = 0;
+    opt_tree_order(0, order, &nb_order);
+    int before = opt_assign_temps(original, nb_pool, slot_of);
+    int after = opt_assign_temps(order, nb_pool, slot_of);
+    if(before == -1 || after == -1 || after >= before) {
+        return 0;
+    }
+
+    // Rewrite the instructions in the new order with their new slots
+    for(int k = 0; k < nb_nodes; k++) {
+        int n = order[k];
+        struct_instruction in = it_get(nodes[n].index);
+        if(n != 0) {
+            in.op1 = pool[slot_of[n]];
+        }
+        if(nodes[n].child[0] != -1) {
+            in.op2 = pool[slot_of[nodes[n].child[0]]];
+        }
+        if(nodes[n].child[1] != -1) {
+            in.op3 = pool[slot_of[nodes[n].child[1]]];
+        }
+        instructions[k] = in;
+    }
+    for(int k = 0; k < nb_nodes; k++) {
+        it_set(first + k, instructions[k]);
+    }
+    printf("Sethi-Ullman: expression at 0x%02x needs %d temporaries instead of %d\n", first, after, before);
+    return before - after;
+}
+
+/* Sethi-Ullman ordering */
+int opt_sethi_ullman() {
+    int reordered = 0;
+    int saved = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        int start, end;
+        cfg_get_function_range(f, &start, &end);
+        cfg_build(&cfg, start, end);
+        df_liveness(&cfg, &liveness);
+        memset(in_tree, 0, sizeof(in_tree));
+
+        // Largest trees first: the root is the last instruction of its tree
+        for(int b = 0; b < cfg.nb_blocks; b++) {
+            for(int i = cfg.blocks[b].end - 1; i >= cfg.blocks[b].start; i--) {
+                enum opcode opc = it_get(i).opcode;
+                if(in_tree[i - start] || opc < iADD || opc > iOR) {
+                    continue;
+                }
+                nb_nodes = 0;
+                opt_build_tree(b, i);
+                int tree_saved = opt_order_tree();
+                reordered += tree_saved > 0;
+                saved += tree_saved;
+            }
+        }
+    }
+    printf("Sethi-Ullman: %d expression(s) reordered, %d temporaries saved\n", reordered, saved);
+    return reordered;
+}
+
+//
+// STACK SLOT COLORING
+//
+
+/**
+ * @brief Maximum number of webs of a function
+ *
+ * A web gathers the writes of a slot that reach the same reads. There is
+ * a web for each slot at the entry of the function, then each instruction
+ * writes at most two slots.
+ */
+#define OPT_MAX_WEBS (CFG_MAX_SLOTS + 2 * INSTRUCTIONS_TABLE_SIZE)
+
+/**
+ * @brief Maximum size of the lists of webs of the calls of a function
+ */
+#define OPT_MAX_CALL_WEBS (16 * INSTRUCTIONS_TABLE_SIZE)
+
+/**
+ * @brief Structure for a call of the function being colored
+ *
+ * The frame of the call holds its return value and its arguments, in
+ * consecutive slots. The webs live across the call must
+ * be placed below the frame, which is overwritten by the called function.
+ *
+ * @param tsp the first slot of the frame before coloring
+ * @param nb_params the number of arguments
+ * @param webs the index of the webs of the call in call_webs: first the
+ * webs of the frame, then the webs live across the call
+ * @param nb_across the number of webs live across the call
+ * @param base the first slot of the frame after coloring, -1 if not colored yet
+ */
+typedef struct {
+    int tsp;
+    int nb_params;
+    int webs;
+    int nb_across;
+    int base;
+} struct_call;
+
+/* Webs of the function being colored, merged with a union-find */
+static int web_parent[OPT_MAX_WEBS];
+static int nb_webs;
+
+/* Slot of each web before coloring, -1 if unused */
+static int web_slot[OPT_MAX_WEBS];
+
+/* Slot of each web after coloring, -1 if not colored yet */
+static int web_color[OPT_MAX_WEBS];
+
+/* Call whose frame holds each web, -1 if none */
+static int web_call[OPT_MAX_WEBS];
+
+/* Web copied to or from each web by a COP, -1 if none */
+static int web_copy[OPT_MAX_WEBS];
+
+/* Web of each slot at the start of each block, -1 if unknown */
+static int web_in[CFG_MAX_BLOCKS][CFG_MAX_SLOTS];
+
+/* Interferences between the webs: a bit is set if both are live at once */
+static bitset_word interference[OPT_MAX_WEBS][BS_WORDS(OPT_MAX_WEBS)];
+
+/* Calls of the function being colored */
+static struct_call calls[INSTRUCTIONS_TABLE_SIZE];
+static int nb_calls;
+static int call_webs[OPT_MAX_CALL_WEBS];
+static int nb_call_webs;
+
+/* Find the representative of a web */
+static int opt_find_web(int w) {
+    while(web_parent[w] != w) {
+        web_parent[w] = web_parent[web_parent[w]];
+        w = web_parent[w];
+    }
+    return w;
+}
+
+/* Merge two webs, returns true if they were different */
+static bool opt_merge_webs(int a, int b) {
+    a = opt_find_web(a);
+    b = opt_find_web(b);
+    if(a == b) {
+        return false;
+    }
+    web_parent[b] = a;
+    return true;
+}
+
+/* Get the web of a write of an instruction */
+static int opt_def_web(int index, int d) {
+    return CFG_MAX_SLOTS + 2 * (index - cfg.start) + d;
+}
+
+/* Get the webs of the slots at the start of a block */
+static void opt_block_webs(int b, int* current, int nb_slots) {
+    for(int s = 0; s < nb_slots; s++) {
+        // Unreachable blocks read the values of the entry
+        current[s] = web_in[b][s] == -1 ? s : web_in[b][s];
+    }
+}
+
+/* Follow the webs of the slots through an instruction */
+static bool opt_web_step(int index, int* current) {
+    struct_effects e = it_get_effects(index);
+    bool changed = false;
+    // A NOT reads and writes the same operand, in the same web
+    if(it_get(index).opcode == iNOT) {
+        changed = opt_merge_webs(current[e.uses[0]], opt_def_web(index, 0));
+    }
+    for(int d = 0; d < e.nb_defs; d++) {
+        current[e.defs[d]] = opt_def_web(index, d);
+        web_slot[opt_def_web(index, d)] = e.defs[d];
+    }
+    return changed;
+}
+
+/**
+ * @brief Get the number of slots of a function, frames of the calls included
+ *
+ * @param start the index of the first instruction of the function
+ * @param end the index after the last instruction of the function
+ * @return int the number of slots, -1 if the function cannot be colored
+ */
+static int opt_frame_size(int start, int end) {
+    int size = 1;
+    for(int i = start; i < end; i++) {
+        struct_instruction in = it_get(i);
+        int* slots[3];
+        int n = it_get_slot_operands(&in, slots);
+        for(int s = 0; s < n; s++) {
+            if(!opt_is_tracked(*slots[s])) {
+                return -1;
+            }
+            size = *slots[s] + 1 > size ? *slots[s] + 1 : size;
+        }
+        // The frame of a call must be known
+        if(in.opcode == iENTER) {
+            struct_effects e = it_get_effects(i);
+            if(e.use_to == -1 || e.use_to > CFG_MAX_SLOTS) {
+                return -1;
+            }
+            size = e.use_to > size ? e.use_to : size;
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Build the webs of the slots of a function
+ *
+ * The writes of the slots are followed along the control flow graph. Where
+ * the paths join, the webs of a live slot are merged.
+ *
+ * @param nb_slots the number of slots of the function
+ */
+static void opt_build_webs(int nb_slots) {
+    static int current[CFG_MAX_SLOTS];
+    nb_webs = opt_def_web(cfg.end, 0);
+    for(int w = 0; w < nb_webs; w++) {
+        web_parent[w] = w;
+        web_slot[w] = w < nb_slots ? w : -1;
+        web_color[w] = -1;
+        web_call[w] = -1;
+        web_copy[w] = -1;
+    }
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        for(int s = 0; s < nb_slots; s++) {
+            web_in[b][s] = b == 0 ? s : -1;
+        }
+    }
+
+    bool changed = true;
+    while(changed) {
+        changed = false;
+        for(int o = 0; o < cfg.nb_reachable; o++) {
+            int b = cfg.order[o];
+            opt_block_webs(b, current, nb_slots);
+            for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+                changed = opt_web_step(i, current) || changed;
+            }
+            for(int n = 0; n < cfg.blocks[b].nb_succ; n++) {
+                int succ = cfg.blocks[b].succ[n];
+                for(int s = 0; s < nb_slots; s++) {
+                    if(web_in[succ][s] == -1) {
+                        web_in[succ][s] = current[s];
+                        changed = true;
+                    } else if(bs_test(liveness.live_in[succ], s)) {
+                        changed = opt_merge_webs(web_in[succ][s], current[s]) || changed;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Mark two webs as interfering */
+static void opt_interfere(int a, int b) {
+    a = opt_find_web(a);
+    b = opt_find_web(b);
+    if(a != b) {
+        bs_set(interference[a], b);
+        bs_set(interference[b], a);
+    }
+}
+
+/* Give its slot to a web that cannot move */
+static bool opt_pin_web(int w, int slot) {
+    w = opt_find_web(w);
+    if(web_call[w] != -1 || (web_color[w] != -1 && web_color[w] != slot)) {
+        return false;
+    }
+    web_color[w] = slot;
+    return true;
+}
+
+/**
+ * @brief Add a call to the calls of the function being colored
+ *
+ * @param index the index of the ENTER
+ * @param live the live slots after the ENTER
+ * @param current the webs of the slots after the ENTER
+ * @param nb_slots the number of slots of the function
+ * @return true if the call has been added
+ */
+static bool opt_add_call(int index, bool* live, int* current, int nb_slots) {
+    struct_effects e = it_get_effects(index);
+    struct_call* call = &calls[nb_calls];
+    call->tsp = e.clobber_from;
+    call->nb_params = e.use_to - e.use_from;
+    call->webs = nb_call_webs;
+    call->nb_across = 0;
+    call->base = -1;
+
+    // The webs of the frame belong to this call only
+    for(int k = 0; k < 1 + call->nb_params; k++) {
+        int w = opt_find_web(k == 0 ? opt_def_web(index, 0) : current[call->tsp + k]);
+        if(web_call[w] != -1 || web_color[w] != -1 || nb_call_webs == OPT_MAX_CALL_WEBS) {
+            return false;
+        }
+        web_call[w] = nb_calls;
+        call_webs[nb_call_webs++] = w;
+    }
+    // The webs live across the call must already be below its frame
+    for(int s = 0; s < nb_slots; s++) {
+        if(!live[s] || s == call->tsp) {
+            continue;
+        }
+        if(s >= call->tsp || nb_call_webs == OPT_MAX_CALL_WEBS) {
+            return false;
+        }
+        call_webs[nb_call_webs++] = opt_find_web(current[s]);
+        call->nb_across++;
+    }
+    nb_calls++;
+    return true;
+}
+
+/**
+ * @brief Compute the interferences between the webs of a function
+ *
+ * A write interferes with the webs of the slots live after it, except
+ * for the source of a COP, which holds the same value. The calls of the
+ * function, the web of the return value read by the LEAVE and the webs
+ * related by a COP are also collected.
+ *
+ * @param nb_slots the number of slots of the function
+ * @return true if the function can be colored
+ */
+static bool opt_build_interference(int nb_slots) {
+    static int current[CFG_MAX_SLOTS];
+    static bool live_after[INSTRUCTIONS_TABLE_SIZE][CFG_MAX_SLOTS];
+    for(int w = 0; w < nb_webs; w++) {
+        memset(interference[w], 0, sizeof(interference[w]));
+    }
+    nb_calls = 0;
+    nb_call_webs = 0;
+
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        struct_block* block = &cfg.blocks[b];
+
+        // Live slots after each instruction of the block
+        for(int s = 0; s < CFG_MAX_SLOTS; s++) {
+            live_after[block->end - 1 - cfg.start][s] = bs_test(liveness.live_out[b], s);
+        }
+        for(int i = block->end - 1; i > block->start; i--) {
+            memcpy(live_after[i - 1 - cfg.start], live_after[i - cfg.start], sizeof(live_after[0]));
+            cfg_transfer(i, live_after[i - 1 - cfg.start]);
+        }
+
+        opt_block_webs(b, current, nb_slots);
+        if(b == 0) {
+            // The values live at the entry of the function interfere
+            for(int s = 0; s < nb_slots; s++) {
+                for(int t = s + 1; t < nb_slots; t++) {
+                    if(bs_test(liveness.live_in[0], s) && bs_test(liveness.live_in[0], t)) {
+                        opt_interfere(current[s], current[t]);
+                    }
+                }
+            }
+        }
+        for(int i = block->start; i < block->end; i++) {
+            struct_instruction in = it_get(i);
+            if(in.opcode == iLEAVE && !opt_pin_web(current[0], 0)) {
+                return false;
+            }
+            int source = in.opcode == iCOP ? opt_find_web(current[in.op2]) : -1;
+            opt_web_step(i, current);
+            if(source != -1) {
+                web_copy[opt_find_web(current[in.op1])] = source;
+                web_copy[source] = opt_find_web(current[in.op1]);
+            }
+            struct_effects e = it_get_effects(i);
+            bool* live = live_after[i - cfg.start];
+            for(int d = 0; d < e.nb_defs; d++) {
+                for(int s = 0; s < nb_slots; s++) {
+                    if(live[s] && s != e.defs[d] && opt_find_web(current[s]) != source) {
+                        opt_interfere(current[e.defs[d]], current[s]);
+                    }
+                }
+            }
+            if(in.opcode == iENTER && !opt_add_call(i, live, current, nb_slots)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Check if a web can take a slot, given the webs already colored */
+static bool opt_color_free(int w, int color) {
+    for(int j = 0; j < BS_WORDS(OPT_MAX_WEBS); j++) {
+        for(int k = 0; interference[w][j] != 0 && k < BS_WORD_BITS; k++) {
+            if(((interference[w][j] >> k) & 1) && web_color[j * BS_WORD_BITS + k] == color) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/* Place the frame of a call above the return value, the parameters and the webs live across it */
+static bool opt_color_call(struct_call* call, int nb_pinned) {
+    if(call->base != -1) {
+        return true;
+    }
+    int frame_size = 1 + call->nb_params;
+    int base = nb_pinned;
+    for(int a = 0; a < call->nb_across; a++) {
+        int color = web_color[call_webs[call->webs + frame_size + a]];
+        if(color == -1) {
+            return false;
+        }
+        base = color + 1 > base ? color + 1 : base;
+    }
+    for(; base + frame_size <= CFG_MAX_SLOTS; base++) {
+        bool is_free = true;
+        for(int k = 0; is_free && k < frame_size; k++) {
+            is_free = opt_color_free(call_webs[call->webs + k], base + k);
+        }
+        if(is_free) {
+            call->base = base;
+            for(int k = 0; k < frame_size; k++) {
+                web_color[call_webs[call->webs + k]] = base + k;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Give a slot to each web of a function
+ *
+ * The webs are colored in the order of their slots, so that the webs live
+ * across a call are colored before its frame. Each web takes the slot of
+ * the web it is copied to or from if possible, so that the COP can be
+ * removed, or else the lowest slot not taken by an interfering web.
+ * The frames of the calls stay above the return value and the
+ * parameters, even once they are dead, so that a slot added below the
+ * frames by opt_new_slot does not move them.
+ *
+ * @param nb_slots the number of slots of the function
+ * @param nb_pinned the number of slots of the return value and the parameters
+ * @return int the number of slots after coloring, -1 if the coloring failed
+ */
+static int opt_color_webs(int nb_slots, int nb_pinned) {
+    int size = 0;
+    for(int s = 0; s < nb_slots; s++) {
+        for(int w = 0; w < nb_webs; w++) {
+            if(web_slot[w] != s || opt_find_web(w) != w) {
+                continue;
+            }
+            if(web_call[w] != -1) {
+                if(!opt_color_call(&calls[web_call[w]], nb_pinned)) {
+                    return -1;
+                }
+            } else if(web_color[w] == -1) {
+                int copy = web_copy[w] == -1 ? -1 : web_color[opt_find_web(web_copy[w])];
+                int color = 0;
+                if(copy != -1 && opt_color_free(w, copy)) {
+                    color = copy;
+                }
+                while(!opt_color_free(w, color)) {
+                    color++;
+                }
+                web_color[w] = color;
+            } else if(!opt_color_free(w, web_color[w])) {
+                return -1; // Two pinned webs interfere
+            }
+            size = web_color[w] + 1 > size ? web_color[w] + 1 : size;
+        }
+    }
+    return size;
+}
+
+/* Rewrite the slots of a function with the colors of their webs */
+static void opt_rewrite_slots(int nb_slots) {
+    static int current[CFG_MAX_SLOTS];
+    static struct_instruction rewritten[INSTRUCTIONS_TABLE_SIZE];
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        opt_block_webs(b, current, nb_slots);
+        for(int i = cfg.blocks[b].start; i < cfg.blocks[b].end; i++) {
+            struct_instruction in = it_get(i);
+            int* slots[3];
+            int n = it_get_slot_operands(&in, slots);
+            if(in.opcode == iENTER) {
+                // The frame of the call starts at its return value
+                *slots[0] = web_color[opt_find_web(opt_def_web(i, 0))];
+            } else {
+                // The first slot operand is the result, except for JMPF and PRINT
+                int first_use = (in.opcode == iJMPF || in.opcode == iPRINT) ? 0 : 1;
+                for(int s = first_use; s < n; s++) {
+                    *slots[s] = web_color[opt_find_web(current[*slots[s]])];
+                }
+                if(first_use == 1 && n > 0) {
+                    *slots[0] = web_color[opt_find_web(opt_def_web(i, 0))];
+                }
+            }
+            opt_web_step(i, current);
+            rewritten[i - cfg.start] = in;
+        }
+    }
+    for(int i = cfg.start; i < cfg.end; i++) {
+        it_set(i, rewritten[i - cfg.start]);
+    }
+}
+
+/**
+ * @brief Color the slots of a function
+ *
+ * @param function the index of the function in the functions table
+ * @param size the number of slots of the function, -1 if it cannot be colored
+ * @return int the number of slots after coloring, -1 if the function is left as is
+ */
+static int opt_slot_coloring_function(int function, int* size) {
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    *size = opt_frame_size(start, end);
+    if(*size == -1 || cfg.nb_blocks == 0) {
+        return -1;
+    }
+    df_liveness(&cfg, &liveness);
+    opt_build_webs(*size);
+
+    // The return value and the parameters do not move
+    int nb_pinned = 1 + ft_search_by_address(function).nb_params;
+    for(int s = 0; s < nb_pinned && s < *size; s++) {
+        if(!opt_pin_web(s, s)) {
+            return -1;
+        }
+    }
+    if(!opt_build_interference(*size)) {
+        return -1;
+    }
+    int colored = opt_color_webs(*size, nb_pinned);
+    if(colored == -1 || colored >= *size) {
+        return -1;
+    }
+    opt_rewrite_slots(*size);
+    return colored;
+}
+
+/* Remove the copies of a slot to itself, returns the number of removed copies */
+static int opt_remove_self_copies(int function) {
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    int removed = 0;
+    for(int i = end - 1; i >= start; i--) {
+        struct_instruction in = it_get(i);
+        if(in.opcode == iCOP && in.op1 == in.op2) {
+            it_remove(i);
+            removed++;
+        }
+    }
+    return removed;
+}
+
+/* Stack slot coloring */
+int opt_slot_coloring() {
+    int copies = 0;
+    int saved = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        int size;
+        int colored = opt_slot_coloring_function(f, &size);
+        char* name = ft_search_by_address(f).name;
+        if(colored == -1) {
+            printf("Slot coloring: %s keeps %d slot(s)\n", name, size);
+        } else {
+            printf("Slot coloring: %s from %d to %d slot(s)\n", name, size, colored);
+            saved += size - colored;
+        }
+        copies += opt_remove_self_copies(f);
+    }
+    printf("Slot coloring: %d slot(s) saved, %d copies removed\n", saved, copies);
+    return saved;
+}
+
+//
+// BLOCK LAYOUT
+//
+
+/**
+ * @brief Structure for an edge between two blocks
+ *
+ * @param from the source block
+ * @param to the target block
+ * @param weight the estimated number of times the edge is followed
+ * @param fall true if the target follows the source in the original order
+ */
+typedef struct {
+    int from;
+    int to;
+    long long weight;
+    bool fall;
+} struct_edge;
+
+/* Edges that may become a fall through */
+static struct_edge edges[2 * CFG_MAX_BLOCKS];
+static int nb_edges;
+
+/* Jump target and fall through of each block, -1 if none */
+static int block_target[CFG_MAX_BLOCKS];
+static int block_fall[CFG_MAX_BLOCKS];
+
+/* Estimated number of times the edges of each block are followed */
+static long long target_weight[CFG_MAX_BLOCKS];
+static long long fall_weight[CFG_MAX_BLOCKS];
+
+/* Chains of blocks placed one after the other */
+static int chain_next[CFG_MAX_BLOCKS];
+static int chain_prev[CFG_MAX_BLOCKS];
+
+/* Blocks in their new order, and their new index */
+static int layout[CFG_MAX_BLOCKS];
+static int block_index[CFG_MAX_BLOCKS];
+
+/* Instructions of the function in the new order, with the block their jump targets */
+static struct_instruction laid[INSTRUCTIONS_TABLE_SIZE];
+static int laid_target[INSTRUCTIONS_TABLE_SIZE];
+static int nb_laid;
+
+/* Check if an edge leaves a loop containing its source */
+static bool opt_leaves_loop(int from, int to, int nb_loops) {
+    for(int l = 0; l < nb_loops; l++) {
+        if(loops[l].body[from] && !loops[l].body[to]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Static estimate of the edges of a block: a loop iterates 8 times, so a
+   branch leaving it is followed once out of 8 */
+static void opt_static_weights(int b, int nb_loops) {
+    int depth = 0;
+    for(int l = 0; l < nb_loops; l++) {
+        depth += loops[l].body[b];
+    }
+    long long freq = (long long)16 << (3 * (depth < 6 ? depth : 6));
+    int t = block_target[b], f = block_fall[b];
+    target_weight[b] = t != -1 ? freq : 0;
+    fall_weight[b] = f != -1 ? freq : 0;
+    if(t != -1 && f != -1) {
+        bool t_leaves = opt_leaves_loop(b, t, nb_loops);
+        bool f_leaves = opt_leaves_loop(b, f, nb_loops);
+        target_weight[b] = t_leaves == f_leaves ? freq / 2 : (t_leaves ? freq / 8 : freq - freq / 8);
+        fall_weight[b] = freq - target_weight[b];
+    }
+}
+
+/* Edges of a block from the profile, returns false if it is not in the profile */
+static bool opt_profile_weights(int b) {
+    int last = cfg.blocks[b].end - 1;
+    int executed, taken;
+    if(it_get(last).opcode == iJMPF) {
+        if(!pf_branch(last, &executed, &taken)) {
+            return false;
+        }
+        target_weight[b] = taken;
+        fall_weight[b] = executed - taken;
+        return true;
+    }
+    int count = pf_block_count(cfg.blocks[b].start);
+    if(count == -1) {
+        return false;
+    }
+    target_weight[b] = block_target[b] != -1 ? count : 0;
+    fall_weight[b] = block_fall[b] != -1 ? count : 0;
+    return true;
+}
+
+/* Check if the JMPF ending a block can jump to its fall through instead, its condition being inverted */
+static bool opt_can_invert(int b) {
+    struct_instruction jump = it_get(cfg.blocks[b].end - 1);
+    int t = block_target[b], f = block_fall[b];
+    return jump.opcode == iJMPF && t != -1 && f != -1 && opt_is_tracked(jump.op1)
+        && !bs_test(liveness.live_in[t], jump.op1) && !bs_test(liveness.live_in[f], jump.op1);
+}
+
+/* Check if a block never ran, or is never reached */
+static bool opt_is_cold(int b) {
+    return cfg.blocks[b].rpo == -1 || (pf_is_loaded() && pf_block_count(cfg.blocks[b].start) == 0);
+}
+
+/* Order of the edges: heaviest first, then the fall through, then the original order */
+static int opt_compare_edges(const void* a, const void* b) {
+    const struct_edge* x = a;
+    const struct_edge* y = b;
+    if(x->weight != y->weight) {
+        return x->weight > y->weight ? -1 : 1;
+    }
+    if(x->fall != y->fall) {
+        return x->fall ? -1 : 1;
+    }
+    return x->from != y->from ? x->from - y->from : x->to - y->to;
+}
+
+/* Add an edge that may become a fall through */
+static void opt_add_edge(int from, int to, long long weight, bool fall) {
+    // The entry stays first, and a back edge stays a jump to the top of the loop
+    if(to <= 0 || cfg.blocks[to].rpo == -1 || cfg_dominates(&cfg, to, from)) {
+        return;
+    }
+    edges[nb_edges++] = (struct_edge){from, to, weight, fall};
+}
+
+/* Build the chains of blocks, following the heaviest edges first */
+static void opt_build_chains() {
+    nb_edges = 0;
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        chain_next[b] = chain_prev[b] = -1;
+        if(cfg.blocks[b].rpo == -1) {
+            continue;
+        }
+        if(block_target[b] != -1 && block_target[b] != block_fall[b]
+                && (it_get(cfg.blocks[b].end - 1).opcode == iJMP || opt_can_invert(b))) {
+            opt_add_edge(b, block_target[b], target_weight[b], false);
+        }
+        if(block_fall[b] != -1) {
+            opt_add_edge(b, block_fall[b], fall_weight[b], true);
+        }
+    }
+    qsort(edges, nb_edges, sizeof(struct_edge), opt_compare_edges);
+
+    for(int e = 0; e < nb_edges; e++) {
+        int from = edges[e].from, to = edges[e].to;
+        if(chain_next[from] != -1 || chain_prev[to] != -1) {
+            continue;
+        }
+        // The target must not be the head of the chain of the source
+        int head = from;
+        while(chain_prev[head] != -1) {
+            head = chain_prev[head];
+        }
+        if(head != to) {
+            chain_next[from] = to;
+            chain_prev[to] = from;
+        }
+    }
+}
+
+/* Check if the blocks of a chain are all cold */
+static bool opt_chain_is_cold(int head) {
+    for(int b = head; b != -1; b = chain_next[b]) {
+        if(!opt_is_cold(b)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Order the chains: the entry first, then the others in the original order, the cold ones last */
+static void opt_order_chains() {
+    int nb_layout = 0;
+    for(int pass = 0; pass < 3; pass++) {
+        for(int head = 0; head < cfg.nb_blocks; head++) {
+            if(chain_prev[head] != -1 || (pass == 0) != (head == 0)) {
+                continue;
+            }
+            if(pass > 0 && opt_chain_is_cold(head) != (pass == 2)) {
+                continue;
+            }
+            for(int b = head; b != -1; b = chain_next[b]) {
+                layout[nb_layout++] = b;
+            }
+        }
+    }
+}
+
+/* Append an instruction to the laid out instructions, target is the block it jumps to or -1 */
+static void opt_lay(struct_instruction instruction, int target) {
+    laid_target[nb_laid] = target;
+    laid[nb_laid++] = instruction;
+}
+
+/**
+ * @brief Lay out a block before another one
+ *
+ * The jump to the next block is removed, a JMPF to the next block jumps
+ * to its fall through instead and a fall through to another block than
+ * the next one becomes a JMP.
+ *
+ * @param b the block
+ * @param next the next block, -1 for the last block of the function
+ * @param changes the number of removed jumps, added jumps and inverted branches, updated
+ * @return long long the estimated number of jumps taken from the block
+ */
+static long long opt_lay_block(int b, int next, int* changes) {
+    struct_block* block = &cfg.blocks[b];
+    int last = block->end - 1;
+    struct_instruction jump = it_get(last);
+    int t = block_target[b], f = block_fall[b];
+    block_index[b] = nb_laid;
+
+    int body_end = (jump.opcode == iJMP || jump.opcode == iJMPF) ? last : block->end;
+    for(int i = block->start; i < body_end; i++) {
+        opt_lay(it_get(i), -1);
+    }
+
+    long long taken = 0;
+    struct_instruction to_fall = {iJMP, 0, 0, 0, jump.id, jump.line};
+    if(jump.opcode == iJMP) {
+        if(t != -1 && t == next) {
+            changes[0]++;
+        } else {
+            opt_lay(jump, t);
+            taken += target_weight[b];
+        }
+    } else if(jump.opcode == iJMPF && t == next && f != next && opt_can_invert(b)) {
+        // Fall to the target and jump to the fall through instead
+        struct_instruction test = it_get(last - 1);
+        if(body_end > block->start && test.op1 == jump.op1 && test.opcode >= iEQ && test.opcode <= iGE) {
+            laid[nb_laid - 1].opcode = opt_invert_comparison(test.opcode);
+        } else {
+            opt_lay((struct_instruction){iNOT, jump.op1, 0, 0, jump.id, jump.line}, -1);
+        }
+        opt_lay(jump, f);
+        taken += fall_weight[b];
+        changes[2]++;
+    } else if(jump.opcode == iJMPF) {
+        opt_lay(jump, t);
+        taken += target_weight[b];
+        if(f != -1 && f != next) {
+            opt_lay(to_fall, f);
+            taken += fall_weight[b];
+            changes[1]++;
+        }
+    } else if(f != -1 && f != next) {
+        opt_lay(to_fall, f);
+        taken += fall_weight[b];
+        changes[1]++;
+    }
+    return taken;
+}
+
+/* Replace the instructions of the function by the laid out instructions */
+static void opt_replace_function() {
+    int start = cfg.start, size = cfg.end - cfg.start;
+    int delta = nb_laid - size;
+    // Insert and remove inside the function, so that its start does not move
+    for(; size < nb_laid; size++) {
+        it_insert_at(start + 1, iNOP, 0, 0, 0);
+    }
+    for(; size > nb_laid; size--) {
+        it_remove(start + 1);
+    }
+    for(int k = 0; k < nb_laid; k++) {
+        it_set(start + k, laid[k]);
+        int target = it_get_target(start + k);
+        if(laid_target[k] != -1) {
+            it_set_target(start + k, start + block_index[laid_target[k]]);
+        } else if(target >= cfg.end) {
+            // The jumps and calls after the function follow its new size
+            it_set_target(start + k, target + delta);
+        }
+    }
+}
+
+/* Lay out the blocks of a function, returns the number of moved blocks */
+static int opt_block_layout_function(int function) {
+    int start, end;
+    cfg_get_function_range(function, &start, &end);
+    cfg_build(&cfg, start, end);
+    if(cfg.nb_blocks < 2) {
+        return 0;
+    }
+    int nb_loops = cfg_find_loops(&cfg, loops);
+    df_liveness(&cfg, &liveness);
+
+    bool profiled = pf_is_loaded();
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        struct_block* block = &cfg.blocks[b];
+        enum opcode opc = it_get(block->end - 1).opcode;
+        int target = it_get_target(block->end - 1);
+        block_target[b] = (opc == iJMP || opc == iJMPF) ? cfg_block_of(&cfg, target) : -1;
+        block_fall[b] = (opc != iJMP && opc != iLEAVE && b + 1 < cfg.nb_blocks) ? b + 1 : -1;
+        if(!profiled || !opt_profile_weights(b)) {
+            opt_static_weights(b, nb_loops);
+        }
+    }
+
+    // Jumps taken in the original order
+    long long before = 0;
+    for(int b = 0; b < cfg.nb_blocks; b++) {
+        before += target_weight[b];
+    }
+
+    opt_build_chains();
+    opt_order_chains();
+    nb_laid = 0;
+    int changes[3] = {0, 0, 0}; // removed, added, inverted
+    long long after = 0;
+    int moved = 0;
+    for(int p = 0; p < cfg.nb_blocks; p++) {
+        after += opt_lay_block(layout[p], p + 1 < cfg.nb_blocks ? layout[p+1] : -1, changes);
+        moved += layout[p] != p;
+    }
+
+    char* name = ft_search_by_address(function).name;
+    if(moved == 0 && changes[0] + changes[1] + changes[2] == 0) {
+        return 0;
+    }
+    if(it_get_index() + nb_laid - (end - start) > INSTRUCTIONS_TABLE_SIZE) {
+        printf("Layout: %s not laid out, the instructions table is full\n", name);
+        return 0;
+    }
+    opt_replace_function();
+    printf("Layout: %s, %d block(s) moved, %d jump(s) removed, %d added, %d branch(es) inverted\n",
+        name, moved, changes[0], changes[1], changes[2]);
+    if(profiled) {
+        printf("Layout: %s, %lld -> %lld taken jump(s) in the profile\n", name, before, after);
+    }
+    return moved + changes[0];
+}
+
+/* Basic block layout */
+int opt_block_layout() {
+    int moved = 0;
+    for(int f = 0; f < ft_get_count(); f++) {
+        moved += opt_block_layout_function(f);
+    }
+    printf("Layout: %d change(s)\n", moved);
+    return moved;
+}
@@ -0,0 +1,210 @@
+/**
+ * @file optimizer.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the optimizations
+ *
+ * The optimizations rewrite the instructions table once the whole
+ * program has been parsed. They work function by function on the
+ * control flow graph of the function, see cfg.h.
+ *
+ * Each optimization returns the number of changes it made, so that
+ * the effect of the optimization can be reported.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+/**
+ * @brief Sparse conditional constant propagation
+ *
+ * This optimization propagates the constants set by AFC through the
+ * copies and the operations, across the blocks of each function. The
+ * blocks are only visited when an executed edge reaches them, and a
+ * JMPF whose condition is known only follows one of its edges.
+ *
+ * The operations whose result is always the same become an AFC, the
+ * JMPF whose condition is known become a JMP or are removed, and the
+ * blocks that are never executed are removed. The JMP left to the next
+ * instruction, and the AFC whose result is no longer read, such as the
+ * operands of a folded comparison, are removed too. A division by zero
+ * is not folded.
+ *
+ * @return int the number of folded and removed instructions
+ */
+int opt_sccp();
+
+/**
+ * @brief Strength reduction of multiplications and divisions
+ *
+ * This optimization rewrites the multiplications and divisions by a
+ * constant set by an AFC of the same block into cheaper operations:
+ * - x * 0, x * 1 and x * 2 into AFC, COP and ADD
+ * - x * 2^k into a shift left
+ * - x * (2^k + 1) and x * (2^k - 1) into a shift left and an ADD or a SOU
+ * - x / 2^k into an arithmetic shift right. The dividend is biased when
+ *   negative, so that the division still rounds toward zero.
+ *
+ * The slot of the constant must only be read by the multiplication or
+ * the division, as it is reused as a scratch slot.
+ *
+ * @return int the number of rewritten instructions
+ */
+int opt_strength_reduction();
+
+/**
+ * @brief Local value numbering
+ *
+ * This optimization gives a number to each value computed in a basic
+ * block: two operations with the same opcode and operands of the same
+ * values compute the same value. The values are forgotten when their
+ * slot is written by another instruction, including the frame of an ENTER.
+ *
+ * An operation whose value is already held by its result, or a copy
+ * between two slots holding the same value, is removed. Otherwise, if
+ * the value is held by another slot, the readers of the result read
+ * that slot instead and the operation is removed. If the result is
+ * read elsewhere, the operation is replaced by a copy, except an AFC:
+ * a constant costs no more than a copy, and less in the registers of
+ * the processor, where a copy of a slot is a LOAD and a STORE.
+ *
+ * @return int the number of removed instructions and of operations replaced by a copy
+ */
+int opt_value_numbering();
+
+/**
+ * @brief Loop-invariant code motion
+ *
+ * This optimization hoists the computations of a loop whose operands
+ * are not written in the loop into a preheader, placed just before
+ * the header of the loop. The preheader is executed once, when the
+ * loop is entered.
+ *
+ * An instruction is hoisted as is if its result is written only by
+ * itself in the loop, and is not read before it in the loop nor after
+ * the loop unless it is always executed. Otherwise, if its result is
+ * only read by the following instructions of its block, like the
+ * temporary variables of an expression, it is hoisted into a new slot
+ * of the frame. The new slot is placed below the frames of the calls,
+ * so that it is not overwritten by an ENTER.
+ *
+ * A division is only hoisted if it is always executed by the loop.
+ *
+ * @return int the number of hoisted instructions
+ */
+int opt_licm();
+
+/**
+ * @brief Constant for the default number of copies of the body of an
+ * unrolled loop
+ */
+#define UNROLL_FACTOR 4
+
+/**
+ * @brief Constant for the maximum number of instructions of the copies
+ * of the body of an unrolled loop
+ */
+#define UNROLL_MAX_SIZE 64
+
+/**
+ * @brief Loop unrolling
+ *
+ * This optimization unrolls the loops made of a single block ending with
+ * a comparison of an induction variable and a JMPF back to the block, as
+ * generated for a while loop. The induction variable must be written once
+ * in the loop, by adding or subtracting a constant, and the bound it is
+ * compared to must not be written in the loop.
+ *
+ * If the values of the induction variable and the bound are constant when
+ * the loop is entered, the number of iterations is known: the loop is
+ * fully unrolled if its copies fit in UNROLL_MAX_SIZE instructions.
+ * Otherwise, the body is copied factor times and the exit test is done
+ * every factor iterations, after peeling the extra iterations.
+ *
+ * If the number of iterations is not known, the copies are run while
+ * i + (factor - 1) * step still compares to the bound, then the original
+ * loop runs the remaining iterations. The induction variable is assumed
+ * not to overflow.
+ *
+ * The factor is lowered when the copies would not fit in UNROLL_MAX_SIZE
+ * instructions. When a profile has been read, see profile.h, the loops
+ * that did not run or ran less than two iterations on average are left
+ * as they are, and the factor is lowered to the average number of
+ * iterations. The reason why each loop is unrolled or not is reported.
+ *
+ * @param factor the number of copies of the body, UNROLL_FACTOR by default
+ * @return int the number of unrolled loops
+ */
+int opt_unroll(int factor);
+
+/**
+ * @brief Sethi-Ullman ordering of the expressions
+ *
+ * The expressions are computed from left to right, as they are parsed,
+ * so right-leaning expressions hold many temporary variables at once.
+ * This optimization rebuilds the expression trees of each block: the
+ * operand of an operation is a subtree if it is computed by an AFC or a
+ * binary operation of the block and only read by this operation.
+ *
+ * Each node is labeled with the number of temporary variables it needs,
+ * and the operand needing more of them is computed first. As the
+ * operations have no side effects, the operands do not need to be
+ * swapped, even for a non commutative operation. The temporary variables
+ * of a reordered tree are then given again from the slots it used.
+ *
+ * @return int the number of reordered expressions
+ */
+int opt_sethi_ullman();
+
+/**
+ * @brief Stack slot coloring
+ *
+ * Each temporary variable and each declared variable has its own slot,
+ * so the frame of a function grows with its code. This optimization
+ * gathers the writes of a slot reaching the same reads into webs, and
+ * gives the same slot to the webs that are never live at the same time,
+ * like the coloring of an interference graph.
+ *
+ * The return value and the parameters keep their slots. The frame of a
+ * call, its return value and arguments, stays in consecutive slots above
+ * the values live across the call, and the frame offset of the ENTER is
+ * rewritten.
+ *
+ * The number of slots of each function, frames of the calls included,
+ * is reported before and after coloring.
+ *
+ * @return int the number of slots saved
+ */
+int opt_slot_coloring();
+
+/**
+ * @brief Basic block layout
+ *
+ * The blocks of a function are laid out in the order of the source, so
+ * the arm of an if that rarely runs sits in the middle of the code and
+ * the jump around it is taken each time. This optimization orders the
+ * blocks of each function so that the likely successor of a block is
+ * the next one, its fall through.
+ *
+ * The edges are weighted with the profile when one has been read, see
+ * profile.h, or else estimated: a loop iterates 8 times, and a branch
+ * leaving a loop is followed once out of 8. The blocks are chained along
+ * the heaviest edges first, the back edges of the loops excepted, then
+ * the chains are placed in the order of the source, the entry first and
+ * the blocks that never ran or are never reached last.
+ *
+ * A JMPF whose target is placed next jumps to its fall through instead:
+ * the comparison computing its condition is inverted, or a NOT is added,
+ * when the condition is not read afterwards. A fall through to another
+ * block than the next one becomes a JMP, and a JMP to the next block is
+ * removed. The jumps taken before and after are reported with a profile.
+ *
+ * @return int the number of moved blocks and removed jumps
+ */
+int opt_block_layout();
+
+#endif // OPTIMIZER_H
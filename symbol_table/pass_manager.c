@@ -0,0 +1,168 @@
+/**
+ * @file pass_manager.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the pass manager
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "pass_manager.h"
+#include <stdio.h>
+#include <stdlib.h> // atoi
+#include <string.h> // strcmp, strncmp, strchr
+#include <time.h>   // clock
+#include "instructions_table.h"
+#include "optimizer.h"
+#include "profile.h"
+#include "token_stream.h"
+
+/* Factor of the loop unrolling */
+static int unroll_factor = UNROLL_FACTOR;
+
+/* Loop unrolling with the factor of the command line */
+static int pm_unroll() {
+    return opt_unroll(unroll_factor);
+}
+
+/* Known passes, in the order of the optimization levels */
+static struct_pass passes[] = {
+    {"sccp", opt_sccp, 1},
+    {"strength", opt_strength_reduction, 1},
+    {"lvn", opt_value_numbering, 1},
+    {"licm", opt_licm, 2},
+    {"unroll", pm_unroll, 2},
+    {"sethi-ullman", opt_sethi_ullman, 1},
+    {"coloring", opt_slot_coloring, 1},
+    {"layout", opt_block_layout, 2},
+};
+#define PM_NB_KNOWN (int)(sizeof(passes) / sizeof(passes[0]))
+
+/* Passes of the pipeline */
+static struct_pass* pipeline[PM_MAX_PASSES];
+static int nb_pipeline = 0;
+
+/* Set by --passes, so that a level does not replace the list */
+static bool passes_given = false;
+
+/* Default pipeline, before the options are parsed */
+static bool pipeline_set = false;
+
+/* Set the pipeline to the passes of an optimization level */
+void pm_set_level(int level) {
+    nb_pipeline = 0;
+    for(int p = 0; p < PM_NB_KNOWN; p++) {
+        if(passes[p].level <= level) {
+            pipeline[nb_pipeline++] = &passes[p];
+        }
+    }
+    pipeline_set = true;
+}
+
+/* Set the pipeline to a list of passes */
+bool pm_set_passes(char* list) {
+    nb_pipeline = 0;
+    pipeline_set = true;
+    while(*list != '\0') {
+        char* comma = strchr(list, ',');
+        int length = comma != NULL ? (int)(comma - list) : (int)strlen(list);
+        int p = 0;
+        while(p < PM_NB_KNOWN && (strncmp(passes[p].name, list, length) != 0 || passes[p].name[length] != '\0')) {
+            p++;
+        }
+        if(p == PM_NB_KNOWN) {
+            fprintf(stderr, "error: unknown pass '%.*s'\n", length, list);
+            return false;
+        }
+        if(nb_pipeline == PM_MAX_PASSES) {
+            fprintf(stderr, "error: more than %d passes\n", PM_MAX_PASSES);
+            return false;
+        }
+        pipeline[nb_pipeline++] = &passes[p];
+        list += comma != NULL ? length + 1 : length;
+    }
+    return true;
+}
+
+/* Parse the options of the command line */
+bool pm_parse_args(int argc, char** argv) {
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-O0") == 0 || strcmp(argv[i], "-O1") == 0 || strcmp(argv[i], "-O2") == 0) {
+            if(!passes_given) {
+                pm_set_level(argv[i][2] - '0');
+            }
+        } else if(strncmp(argv[i], "--passes=", 9) == 0) {
+            passes_given = true;
+            if(!pm_set_passes(argv[i] + 9)) {
+                return false;
+            }
+        } else if(strncmp(argv[i], "--unroll=", 9) == 0 && atoi(argv[i] + 9) > 0) {
+            unroll_factor = atoi(argv[i] + 9);
+        } else if(strcmp(argv[i], "--profile-use") == 0) {
+            if(!pf_load(PM_DEFAULT_PROFILE)) {
+                return false;
+            }
+        } else if(strncmp(argv[i], "--profile-use=", 14) == 0) {
+            if(!pf_load(argv[i] + 14)) {
+                return false;
+            }
+        } else if(strcmp(argv[i], "--threaded-lexer") == 0) {
+            ts_set_threaded(true);
+        } else {
+            fprintf(stderr, "error: unknown option '%s'\n", argv[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Print the usage of the compiler */
+void pm_usage(char* program) {
+    fprintf(stderr, "usage: %s [-O0|-O1|-O2] [--passes=a,b,c] [--unroll=n] [--profile-use[=file]] [--threaded-lexer] < source.c\n", program);
+    fprintf(stderr, "passes:");
+    for(int p = 0; p < PM_NB_KNOWN; p++) {
+        fprintf(stderr, " %s (-O%d)", passes[p].name, passes[p].level);
+    }
+    fprintf(stderr, "\n");
+}
+
+/* Check the instructions table after a pass */
+static bool pm_verify(char* name) {
+    int errors = it_verify();
+    if(errors > 0) {
+        printf("Error: %d error(s) in the instructions table after %s\n", errors, name);
+        fprintf(stderr, "error: invalid instructions table after %s\n", name);
+        return false;
+    }
+    return true;
+}
+
+/* Run the pipeline over the instructions table */
+int pm_run() {
+    if(!pipeline_set) {
+        pm_set_level(2);
+    }
+    if(!pm_verify("parsing")) {
+        return -1;
+    }
+    it_set_fingerprint();
+    pf_check();
+
+    int total = 0;
+    double total_ms = 0;
+    for(int p = 0; p < nb_pipeline; p++) {
+        int before = it_get_index();
+        clock_t start = clock();
+        int changes = pipeline[p]->run();
+        double ms = (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+        if(!pm_verify(pipeline[p]->name)) {
+            return -1;
+        }
+        printf("Pass %-12s %4d change(s), %4d -> %4d instructions, %8.3f ms\n",
+            pipeline[p]->name, changes, before, it_get_index(), ms);
+        total += changes;
+        total_ms += ms;
+    }
+    printf("Passes: %d pass(es), %d change(s), %d instructions, %.3f ms\n", nb_pipeline, total, it_get_index(), total_ms);
+    return total;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file pass_manager.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the pass manager
+ *
+ * The pass manager runs the optimizations of optimizer.h over the
+ * instructions table, between the parsing and the printing of the
+ * assembly code. The pipeline is given by an optimization level or
+ * by a list of passes on the command line:
+ * - -O0 runs no pass
+ * - -O1 runs the passes that do not make the code larger
+ * - -O2 also runs the loop optimizations, it is the default
+ * - --passes=a,b,c runs the given passes in this order, whatever the level.
+ *   Any order is allowed and a pass may be repeated: the passes adding
+ *   slots keep the return value and the parameters in place, even after
+ *   the slot coloring, see test.sh which runs the samples with the
+ *   options given on their "// Options:" line
+ * - --unroll=n sets the factor of the loop unrolling
+ * - --profile-use=file reads a profile written by the interpreter, see
+ *   profile.h, PM_DEFAULT_PROFILE if no file is given. The loop unrolling
+ *   then leaves the loops that did not run and lowers its factor to the
+ *   average number of iterations of each loop, and the block layout
+ *   follows the edges that ran the most.
+ * - --threaded-lexer runs the scanner on its own thread, see token_stream.h
+ *
+ * Each pass is timed and the instructions table is checked after it, so
+ * that a broken table is reported with the pass that broke it.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef PASS_MANAGER_H
+#define PASS_MANAGER_H
+
+#include <stdbool.h> // bool type
+
+/**
+ * @brief Constant for the maximum number of passes of the pipeline
+ */
+#define PM_MAX_PASSES 32
+
+/**
+ * @brief Constant for the profile read by --profile-use without a file
+ */
+#define PM_DEFAULT_PROFILE "profile.txt"
+
+/**
+ * @brief Structure for an optimization pass
+ *
+ * @param name the name of the pass, as given to --passes
+ * @param run the function running the pass, returns its number of changes
+ * @param level the lowest optimization level running the pass
+ */
+typedef struct {
+    char* name;
+    int (*run)();
+    int level;
+} struct_pass;
+
+/**
+ * @brief Parse the options of the command line
+ *
+ * The options set the pipeline of the pass manager, see above. An
+ * unknown option or pass is reported on the error output.
+ *
+ * @param argc the number of arguments
+ * @param argv the arguments, the first one is the program name
+ * @return true if the options are valid
+ */
+bool pm_parse_args(int argc, char** argv);
+
+/**
+ * @brief Print the usage of the compiler on the error output
+ *
+ * @param program the name of the program
+ */
+void pm_usage(char* program);
+
+/**
+ * @brief Set the pipeline to the passes of an optimization level
+ *
+ * @param level the optimization level, from 0 to 2
+ */
+void pm_set_level(int level);
+
+/**
+ * @brief Set the pipeline to a list of passes
+ *
+ * The passes run in the order of the list, each as many times as it is
+ * given.
+ *
+ * @param list the names of the passes, separated by commas
+ * @return true if every pass exists
+ */
+bool pm_set_passes(char* list);
+
+/**
+ * @brief Run the pipeline over the instructions table
+ *
+ * The instructions table is checked once before the first pass and
+ * after each pass. The number of changes, the number of instructions
+ * and the time of each pass are reported.
+ *
+ * @return int the total number of changes, -1 if a check failed
+ */
+int pm_run();
+
+#endif // PASS_MANAGER_H
@@ -0,0 +1,135 @@
+/**
+ * @file profile.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the execution profiles
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "profile.h"
+#include <stdio.h>
+#include "instructions_table.h"
+
+/* Counts of the records by id, -1 if not in the profile */
+static int block_count[INSTRUCTIONS_TABLE_SIZE + 1];
+static int branch_count[INSTRUCTIONS_TABLE_SIZE + 1];
+static int branch_taken[INSTRUCTIONS_TABLE_SIZE + 1];
+static int call_count[INSTRUCTIONS_TABLE_SIZE + 1];
+
+/* Set once a profile has been read */
+static bool loaded = false;
+
+/* Name and fingerprint of the program the profile was taken on, count -1 if not given */
+static char profile_name[256];
+static int profile_count = -1;
+static unsigned int profile_hash = 0;
+
+/* Add a count to a record, the copies of an instruction share its id */
+static void pf_add(int* counts, int id, int count) {
+    counts[id] = counts[id] == -1 ? count : counts[id] + count;
+}
+
+/* Read a profile written by the interpreter */
+bool pf_load(char* filename) {
+    FILE* file = fopen(filename, "r");
+    if(file == NULL) {
+        fprintf(stderr, "error: cannot read the profile '%s'\n", filename);
+        return false;
+    }
+    for(int id = 0; id <= INSTRUCTIONS_TABLE_SIZE; id++) {
+        block_count[id] = branch_count[id] = branch_taken[id] = call_count[id] = -1;
+    }
+
+    snprintf(profile_name, sizeof(profile_name), "%s", filename);
+    profile_count = -1;
+
+    char line[128];
+    int nb_blocks = 0, nb_branches = 0, nb_calls = 0, nb_skipped = 0;
+    while(fgets(line, sizeof(line), file) != NULL) {
+        if(sscanf(line, " # fingerprint %d %x", &profile_count, &profile_hash) == 2) {
+            continue;
+        }
+        char kind;
+        int index, id, source_line, count, extra;
+        int fields = sscanf(line, " %c %d %d %d %d %d", &kind, &index, &id, &source_line, &count, &extra);
+        if(fields < 1 || kind == '#') {
+            continue;
+        }
+        if(fields < 5 || id <= 0 || id > INSTRUCTIONS_TABLE_SIZE) {
+            nb_skipped++;
+            continue;
+        }
+        if(kind == 'B') {
+            pf_add(block_count, id, count);
+            nb_blocks++;
+        } else if(kind == 'J' && fields == 6) {
+            pf_add(branch_count, id, count);
+            pf_add(branch_taken, id, extra);
+            nb_branches++;
+        } else if(kind == 'C') {
+            pf_add(call_count, id, count);
+            nb_calls++;
+        } else {
+            nb_skipped++;
+        }
+    }
+    fclose(file);
+    loaded = true;
+    printf("Profile: %d block(s), %d branch(es), %d call site(s) read from %s, %d record(s) skipped\n",
+        nb_blocks, nb_branches, nb_calls, filename, nb_skipped);
+    return true;
+}
+
+/* Check that the profile has been taken on the program being compiled */
+bool pf_check() {
+    if(!loaded) {
+        return false;
+    }
+    unsigned int hash;
+    int count = it_get_fingerprint(&hash);
+    if(profile_count != count || profile_hash != hash) {
+        fprintf(stderr, "warning: the profile '%s' was not taken on this program, it is ignored\n", profile_name);
+        printf("Profile: fingerprint %d %08x of %s does not match %d %08x, profile ignored\n",
+            profile_count, profile_hash, profile_name, count, hash);
+        loaded = false;
+        return false;
+    }
+    return true;
+}
+
+/* Check if a profile has been read */
+bool pf_is_loaded() {
+    return loaded;
+}
+
+/* Get the id of an instruction, 0 if it has none or no profile has been read */
+static int pf_id(int index) {
+    if(!loaded || index < 0 || index >= it_get_index()) {
+        return 0;
+    }
+    return it_get(index).id;
+}
+
+/* Get the number of executions of the block starting at an instruction */
+int pf_block_count(int index) {
+    int id = pf_id(index);
+    return id != 0 ? block_count[id] : -1;
+}
+
+/* Get the number of executions of a JMPF and of its jumps */
+bool pf_branch(int index, int* executed, int* taken) {
+    int id = pf_id(index);
+    if(id == 0 || it_get(index).opcode != iJMPF || branch_count[id] == -1) {
+        return false;
+    }
+    *executed = branch_count[id];
+    *taken = branch_taken[id];
+    return true;
+}
+
+/* Get the number of executions of an ENTER */
+int pf_call_count(int index) {
+    int id = pf_id(index);
+    return id != 0 && it_get(index).opcode == iENTER ? call_count[id] : -1;
+}
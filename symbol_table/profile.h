@@ -0,0 +1,91 @@
+/**
+ * @file profile.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the execution profiles
+ *
+ * The interpreter writes a profile of a run when it is started with
+ * --profile, see interpreter.py. The profile is keyed by the ids of the
+ * instructions given in asm.map, which stay the same between two
+ * compilations of the same source, and gives the source line of each
+ * record. Each line of the profile is a record:
+ * - B index id line count, the number of executions of a block
+ * - J index id line count taken, the number of executions of a JMF and
+ *   the number of times it jumped
+ * - C index id line count callee, the number of executions of an ENTER
+ *
+ * The profile starts with the fingerprint of the program it was taken
+ * on, copied from asm.map, see it_set_fingerprint. The compiler reads
+ * the profile back with --profile-use, see pass_manager.h, and ignores
+ * it if the fingerprint is not the one of the program being compiled.
+ * It is read before the passes run. The records of the copies of
+ * an instruction, e.g. by the loop unrolling, are added together, so
+ * the profile is best taken on a program compiled without unrolling,
+ * e.g. with -O1.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h> // bool type
+
+/**
+ * @brief Read a profile written by the interpreter
+ *
+ * The records whose id is unknown, 0 or too large, are skipped. The
+ * number of records read is reported.
+ *
+ * @param filename the name of the profile
+ * @return true if the profile has been read
+ */
+bool pf_load(char* filename);
+
+/**
+ * @brief Check that the profile read has been taken on the program being compiled
+ *
+ * The fingerprint of the profile is compared to the one recorded by
+ * it_set_fingerprint. If they differ, or the profile has none, a
+ * warning is printed and the profile is ignored.
+ *
+ * @return true if a profile has been read and is kept
+ */
+bool pf_check();
+
+/**
+ * @brief Check if a profile has been read
+ *
+ * @return true if a profile has been read
+ */
+bool pf_is_loaded();
+
+/**
+ * @brief Get the number of executions of the block starting at an instruction
+ *
+ * @param index the index of the first instruction of the block
+ * @return int the number of executions, -1 if not in the profile
+ */
+int pf_block_count(int index);
+
+/**
+ * @brief Get the number of executions of a JMPF and of its jumps
+ *
+ * @param index the index of the JMPF
+ * @param executed the number of executions, filled
+ * @param taken the number of jumps, filled
+ * @return true if the JMPF is in the profile
+ */
+bool pf_branch(int index, int* executed, int* taken);
+
+/**
+ * @brief Get the number of executions of an ENTER
+ *
+ * @param index the index of the ENTER
+ * @return int the number of executions, -1 if not in the profile
+ */
+int pf_call_count(int index);
+
+#endif // PROFILE_H
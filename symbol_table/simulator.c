@@ -0,0 +1,603 @@
+/**
+ * @file simulator.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the processor simulator
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "simulator.h"
+#include <stdio.h>
+#include <stdlib.h> // atoll
+#include <string.h> // strcmp, strncmp, strstr
+#include <limits.h> // INT_MIN
+
+/* An instruction of the ROM, decoded with its extension words, opcode -1 inside an instruction */
+typedef struct {
+    int opcode;
+    int a;
+    int b;
+    int c;
+    int size;
+} struct_word;
+
+/* The causes of a bubble */
+typedef enum {
+    BUBBLE_FILL,
+    BUBBLE_DATA,
+    BUBBLE_CONTROL,
+    BUBBLE_FETCH
+} bubble_cause;
+
+/* The content of a stage, an instruction or a bubble charged to a function */
+typedef struct {
+    bool valid;
+    int pc;
+    int pending;
+    struct_word word;
+    int function;
+    bubble_cause cause;
+    int b;
+    int c;
+    int frame;
+    int result;
+} struct_slot;
+
+/* The counts of a function */
+typedef struct {
+    char name[64];
+    int start;
+    long long instructions;
+    long long cycles;
+    long long data_stalls;
+    long long control_stalls;
+    long long fetch_stalls;
+    long long loads;
+    long long stores;
+} struct_function;
+
+/* Names of the opcodes, NULL for the unused ones */
+static const char* names[SIM_NB_OPCODES] = {
+    [sNOP] = "NOP", [sADD] = "ADD", [sMUL] = "MUL", [sSOU] = "SOU", [sDIV] = "DIV",
+    [sEQU] = "EQU", [sNEQ] = "NEQ", [sLT] = "LT", [sLE] = "LE", [sGT] = "GT", [sGE] = "GE",
+    [sNOT] = "NOT", [sAND] = "AND", [sOR] = "OR", [sJMP] = "JMP", [sJMF] = "JMF", [sPRI] = "PRI",
+    [sENTER] = "ENTER", [sLEAVE] = "LEAVE", [sAFC] = "AFC", [sLOAD] = "LOAD", [sSTORE] = "STORE",
+    [sCOP] = "COP", [sSHL] = "SHL", [sSHR] = "SHR", [sBAND] = "BAND"
+};
+
+static unsigned int words[SIM_ROM_SIZE];
+static struct_word rom[SIM_ROM_SIZE];
+static int rom_size = 0;
+static char* rom_name = "";
+
+static struct_function functions[SIM_MAX_FUNCTIONS];
+static int nb_functions = 0;
+static int function_of[SIM_ROM_SIZE];
+
+/* State of the processor */
+static int registers[SIM_NB_REGISTERS];
+static int memory[SIM_MEMORY_SIZE];
+static int return_pc[SIM_RETURN_STACK_SIZE];
+static int return_frame[SIM_RETURN_STACK_SIZE];
+static int nb_returns = 0;
+static int pc = 0;
+static int frame = 0;
+static bool fetching = true;
+static struct_slot stages[SIM_NB_STAGES];
+
+/* Counts of the last run */
+static long long cycles = 0;
+static long long fill_cycles = 0;
+
+/* Get the register written by an instruction, -1 if none */
+static int sim_writes(struct_word w) {
+    switch(w.opcode) {
+        case sNOP: case sJMP: case sJMF: case sPRI: case sENTER: case sLEAVE: case sSTORE:
+            return -1;
+        default:
+            return w.a;
+    }
+}
+
+/* Get the registers read by an instruction, returns their number */
+static int sim_reads(struct_word w, int* regs) {
+    switch(w.opcode) {
+        case sNOP: case sJMP: case sPRI: case sENTER: case sLEAVE: case sAFC: case sLOAD:
+            return 0;
+        case sNOT: case sCOP: case sSTORE:
+            regs[0] = w.b;
+            return 1;
+        case sJMF:
+            regs[0] = w.a;
+            return 1;
+        default:
+            regs[0] = w.b;
+            regs[1] = w.c;
+            return 2;
+    }
+}
+
+/* Read a ROM written by the cross assembler */
+bool sim_load_rom(char* filename) {
+    FILE* file = fopen(filename, "r");
+    if(file == NULL) {
+        fprintf(stderr, "error: cannot read the ROM '%s'\n", filename);
+        return false;
+    }
+    rom_name = filename;
+    rom_size = 0;
+    char line[256];
+    int line_number = 0;
+    static int lines[SIM_ROM_SIZE];
+    while(fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        if(strstr(line, "others") != NULL) {
+            break;
+        }
+        char* word = strstr(line, "x\"");
+        if(word == NULL) {
+            continue;
+        }
+        unsigned int value;
+        int length = 0;
+        if(sscanf(word + 2, "%8x%n", &value, &length) != 1 || length != 8 || word[2 + length] != '"') {
+            fprintf(stderr, "error: %s:%d: malformed word\n", filename, line_number);
+            fclose(file);
+            return false;
+        }
+        if(rom_size == SIM_ROM_SIZE) {
+            fprintf(stderr, "error: %s: more than %d words\n", filename, SIM_ROM_SIZE);
+            fclose(file);
+            return false;
+        }
+        lines[rom_size] = line_number;
+        words[rom_size++] = value;
+    }
+    fclose(file);
+
+    // Decode the instructions, an extended operand takes the next word
+    for(int i = 0; i < rom_size; ) {
+        unsigned int value = words[i];
+        int opcode = value >> 24;
+        int fields[3] = {(value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff};
+        int flags[3] = {SIM_EXTEND_A, SIM_EXTEND_B, SIM_EXTEND_C};
+        int size = 1;
+        for(int k = 0; k < 3; k++) {
+            if(opcode & flags[k]) {
+                if(i + size == rom_size) {
+                    fprintf(stderr, "error: %s:%d: missing extension word\n", filename, lines[i]);
+                    return false;
+                }
+                fields[k] = (int)words[i + size++];
+            }
+        }
+        struct_word w = {opcode & SIM_OPCODE_MASK, fields[0], fields[1], fields[2], size};
+        if(w.opcode >= SIM_NB_OPCODES || names[w.opcode] == NULL) {
+            fprintf(stderr, "error: %s:%d: unknown opcode %d\n", filename, lines[i], w.opcode);
+            return false;
+        }
+        int regs[3];
+        int nb_regs = sim_reads(w, regs);
+        regs[nb_regs++] = sim_writes(w);
+        for(int r = 0; r < nb_regs; r++) {
+            if(regs[r] < -1 || regs[r] >= SIM_NB_REGISTERS) {
+                fprintf(stderr, "error: %s:%d: no register %d\n", filename, lines[i], regs[r]);
+                return false;
+            }
+        }
+        rom[i] = w;
+        for(int k = 1; k < size; k++) {
+            rom[i + k].opcode = -1;
+        }
+        i += size;
+    }
+
+    // The whole ROM is one function until a map is read
+    nb_functions = 1;
+    memset(&functions[0], 0, sizeof(struct_function));
+    strcpy(functions[0].name, "(program)");
+    memset(function_of, 0, sizeof(int) * rom_size);
+    return true;
+}
+
+/* Read the addresses of the functions of the ROM */
+bool sim_load_map(char* filename) {
+    FILE* file = fopen(filename, "r");
+    if(file == NULL) {
+        return false;
+    }
+    char line[256];
+    nb_functions = 0;
+    while(fgets(line, sizeof(line), file) != NULL && nb_functions < SIM_MAX_FUNCTIONS) {
+        struct_function* f = &functions[nb_functions];
+        memset(f, 0, sizeof(struct_function));
+        if(sscanf(line, "%d %63s", &f->start, f->name) == 2) {
+            nb_functions++;
+        }
+    }
+    fclose(file);
+    if(nb_functions == 0 || functions[0].start != 0) {
+        // The code before the first function gets its own entry
+        memmove(&functions[1], &functions[0], sizeof(struct_function) * (nb_functions < SIM_MAX_FUNCTIONS ? nb_functions : SIM_MAX_FUNCTIONS - 1));
+        memset(&functions[0], 0, sizeof(struct_function));
+        strcpy(functions[0].name, "(start)");
+        nb_functions = nb_functions < SIM_MAX_FUNCTIONS ? nb_functions + 1 : SIM_MAX_FUNCTIONS;
+    }
+
+    int f = 0;
+    for(int i = 0; i < rom_size; i++) {
+        while(f + 1 < nb_functions && functions[f + 1].start <= i) {
+            f++;
+        }
+        function_of[i] = f;
+    }
+    return true;
+}
+
+/* Make a bubble charged to a function */
+static struct_slot sim_bubble(bubble_cause cause, int function) {
+    struct_slot slot = {0};
+    slot.cause = cause;
+    slot.function = function;
+    return slot;
+}
+
+/* Fetch the instruction at pc, the program ends past the end of the ROM */
+static struct_slot sim_fetch() {
+    if(fetching && (pc < 0 || pc >= rom_size)) {
+        fetching = false;
+    }
+    if(!fetching) {
+        return sim_bubble(BUBBLE_FILL, -1);
+    }
+    struct_slot slot = {0};
+    slot.valid = true;
+    slot.pc = pc;
+    slot.word = rom[pc];
+    slot.pending = rom[pc].size - 1;
+    slot.function = function_of[pc];
+    pc += rom[pc].size;
+    return slot;
+}
+
+/* Get the address of a memory access, -1 if out of the memory */
+static int sim_address(struct_slot* slot, int offset) {
+    int address = slot->frame + offset;
+    if(address < 0 || address >= SIM_MEMORY_SIZE) {
+        fprintf(stderr, "error: %s: address %d out of the memory at %d\n", rom_name, address, slot->pc);
+        return -1;
+    }
+    return address;
+}
+
+/* Compute the result of an instruction in the execute stage */
+static bool sim_execute(struct_slot* slot) {
+    int b = slot->b, c = slot->c;
+    switch(slot->word.opcode) {
+        // The operations wrap around, computed in unsigned as signed overflows are undefined
+        case sADD: slot->result = (int)((unsigned int)b + (unsigned int)c); break;
+        case sSOU: slot->result = (int)((unsigned int)b - (unsigned int)c); break;
+        case sMUL: slot->result = (int)((unsigned int)b * (unsigned int)c); break;
+        case sDIV:
+            if(c == 0) {
+                fprintf(stderr, "error: %s: division by zero at %d\n", rom_name, slot->pc);
+                return false;
+            }
+            if(b == INT_MIN && c == -1) {
+                fprintf(stderr, "error: %s: division overflow at %d\n", rom_name, slot->pc);
+                return false;
+            }
+            slot->result = b / c;
+            break;
+        case sEQU: slot->result = b == c; break;
+        case sNEQ: slot->result = b != c; break;
+        case sLT: slot->result = b < c; break;
+        case sLE: slot->result = b <= c; break;
+        case sGT: slot->result = b > c; break;
+        case sGE: slot->result = b >= c; break;
+        case sAND: slot->result = b && c; break;
+        case sOR: slot->result = b || c; break;
+        case sNOT: slot->result = !b; break;
+        case sSHL: slot->result = (int)((unsigned int)b << (c & 31)); break;
+        case sSHR: slot->result = b >> (c & 31); break;
+        case sBAND: slot->result = b & c; break;
+        case sCOP: slot->result = b; break;
+        case sAFC: slot->result = slot->word.b; break;
+        default: break;
+    }
+    return true;
+}
+
+/* Access the memory in the memory stage */
+static bool sim_memory(struct_slot* slot) {
+    struct_function* f = &functions[slot->function];
+    int address;
+    switch(slot->word.opcode) {
+        case sLOAD:
+            if((address = sim_address(slot, slot->word.b)) == -1) {
+                return false;
+            }
+            slot->result = memory[address];
+            f->loads++;
+            break;
+        case sSTORE:
+            if((address = sim_address(slot, slot->word.a)) == -1) {
+                return false;
+            }
+            memory[address] = slot->b;
+            f->stores++;
+            break;
+        case sPRI:
+            if((address = sim_address(slot, slot->word.a)) == -1) {
+                return false;
+            }
+            printf("%d\n", memory[address]);
+            f->loads++;
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+/* Take a JMP, an ENTER or a LEAVE in the decode stage */
+static bool sim_redirect(struct_slot* slot) {
+    struct_word w = slot->word;
+    if(w.opcode == sJMP) {
+        pc = w.a;
+    } else if(w.opcode == sENTER) {
+        if(nb_returns == SIM_RETURN_STACK_SIZE) {
+            fprintf(stderr, "error: %s: stack overflow at %d, more than %d nested calls\n", rom_name, slot->pc, SIM_RETURN_STACK_SIZE);
+            return false;
+        }
+        return_pc[nb_returns] = slot->pc + w.size;
+        return_frame[nb_returns++] = frame;
+        frame += w.b;
+        pc = w.a;
+    } else if(nb_returns == 0) {
+        fetching = false;
+    } else {
+        nb_returns--;
+        pc = return_pc[nb_returns];
+        frame = return_frame[nb_returns];
+    }
+    return true;
+}
+
+/* Check if an instruction must wait in decode for a register */
+static bool sim_hazard(struct_slot* slot) {
+    int regs[2];
+    int nb_regs = sim_reads(slot->word, regs);
+    for(int s = STAGE_EXECUTE; s <= STAGE_MEMORY; s++) {
+        if(!stages[s].valid) {
+            continue;
+        }
+        int written = sim_writes(stages[s].word);
+        for(int r = 0; r < nb_regs; r++) {
+            if(written == regs[r]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/* Print the content of the pipeline */
+static void sim_trace() {
+    printf("%8lld ", cycles);
+    for(int s = 0; s < SIM_NB_STAGES; s++) {
+        if(stages[s].valid) {
+            printf(" %5s@%-5d", names[stages[s].word.opcode], stages[s].pc);
+        } else {
+            printf(" %11s", "-");
+        }
+    }
+    printf("\n");
+}
+
+/* Check if the pipeline holds an instruction */
+static bool sim_busy() {
+    for(int s = 0; s < SIM_NB_STAGES; s++) {
+        if(stages[s].valid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Run the ROM from address 0 */
+bool sim_run(long long max_cycles, bool trace) {
+    memset(registers, 0, sizeof(registers));
+    memset(memory, 0, sizeof(memory));
+    nb_returns = 0;
+    pc = 0;
+    frame = 0;
+    fetching = true;
+    cycles = fill_cycles = 0;
+    for(int s = 0; s < SIM_NB_STAGES; s++) {
+        stages[s] = sim_bubble(BUBBLE_FILL, -1);
+    }
+    stages[STAGE_FETCH] = sim_fetch();
+
+    while(fetching || sim_busy()) {
+        if(stages[STAGE_FETCH].valid && stages[STAGE_FETCH].word.opcode == -1) {
+            fprintf(stderr, "error: %s: jump into the extension word %d\n", rom_name, stages[STAGE_FETCH].pc);
+            return false;
+        }
+        if(max_cycles > 0 && cycles == max_cycles) {
+            printf("Stopped after %lld cycles, see --max-cycles\n", cycles);
+            return true;
+        }
+        cycles++;
+        if(trace) {
+            sim_trace();
+        }
+
+        // Write back, first half of the cycle
+        struct_slot* slot = &stages[STAGE_WRITE_BACK];
+        if(slot->function == -1) {
+            fill_cycles++;
+        } else {
+            struct_function* f = &functions[slot->function];
+            f->cycles++;
+            if(slot->valid) {
+                f->instructions++;
+                int written = sim_writes(slot->word);
+                if(written != -1) {
+                    registers[written] = slot->result;
+                }
+            } else if(slot->cause == BUBBLE_DATA) {
+                f->data_stalls++;
+            } else if(slot->cause == BUBBLE_FETCH) {
+                f->fetch_stalls++;
+            } else {
+                f->control_stalls++;
+            }
+        }
+
+        if(stages[STAGE_MEMORY].valid && !sim_memory(&stages[STAGE_MEMORY])) {
+            return false;
+        }
+
+        // A JMF is taken in execute and cancels the two instructions behind it
+        bool flush = false;
+        slot = &stages[STAGE_EXECUTE];
+        if(slot->valid) {
+            if(!sim_execute(slot)) {
+                return false;
+            }
+            if(slot->word.opcode == sJMF && slot->b == 0) {
+                pc = slot->word.b;
+                flush = true;
+            }
+        }
+
+        // Decode reads the registers, or waits for them
+        bool stall = false, redirect = false;
+        slot = &stages[STAGE_DECODE];
+        if(!flush && slot->valid) {
+            stall = sim_hazard(slot);
+            if(!stall) {
+                int regs[2] = {0, 0};
+                int nb_regs = sim_reads(slot->word, regs);
+                slot->b = nb_regs > 0 ? registers[regs[0]] : slot->word.b;
+                slot->c = nb_regs > 1 ? registers[regs[1]] : slot->word.c;
+                slot->frame = frame;
+                int op = slot->word.opcode;
+                if(op == sJMP || op == sENTER || op == sLEAVE) {
+                    if(!sim_redirect(slot)) {
+                        return false;
+                    }
+                    redirect = true;
+                }
+            }
+        }
+
+        // Move the instructions to the next stages
+        int function = stages[STAGE_DECODE].function;
+        stages[STAGE_WRITE_BACK] = stages[STAGE_MEMORY];
+        stages[STAGE_MEMORY] = stages[STAGE_EXECUTE];
+        if(flush) {
+            int jmf = stages[STAGE_MEMORY].function;
+            stages[STAGE_EXECUTE] = sim_bubble(BUBBLE_CONTROL, jmf);
+            stages[STAGE_DECODE] = sim_bubble(BUBBLE_CONTROL, jmf);
+            stages[STAGE_FETCH] = sim_fetch();
+        } else if(stall) {
+            stages[STAGE_EXECUTE] = sim_bubble(BUBBLE_DATA, function);
+            if(stages[STAGE_FETCH].pending > 0) {
+                stages[STAGE_FETCH].pending--;
+            }
+        } else if(!redirect && stages[STAGE_FETCH].pending > 0) {
+            // The extension words are still being fetched
+            stages[STAGE_EXECUTE] = stages[STAGE_DECODE];
+            stages[STAGE_DECODE] = sim_bubble(BUBBLE_FETCH, stages[STAGE_FETCH].function);
+            stages[STAGE_FETCH].pending--;
+        } else {
+            stages[STAGE_EXECUTE] = stages[STAGE_DECODE];
+            stages[STAGE_DECODE] = redirect ? sim_bubble(BUBBLE_CONTROL, function) : stages[STAGE_FETCH];
+            stages[STAGE_FETCH] = sim_fetch();
+        }
+    }
+    return true;
+}
+
+/* Print the counts of a function or of the whole program */
+static void sim_report_line(char* name, struct_function* f) {
+    printf("%-16s %12lld %12lld %6.2f %12lld %12lld %12lld %10lld %10lld\n", name, f->instructions, f->cycles,
+        f->instructions > 0 ? (double)f->cycles / f->instructions : 0.0,
+        f->data_stalls, f->control_stalls, f->fetch_stalls, f->loads, f->stores);
+}
+
+/* Print the cycles, the CPI, the stalls and the memory accesses of the last run */
+void sim_report() {
+    struct_function total = {0};
+    for(int f = 0; f < nb_functions; f++) {
+        total.instructions += functions[f].instructions;
+        total.cycles += functions[f].cycles;
+        total.data_stalls += functions[f].data_stalls;
+        total.control_stalls += functions[f].control_stalls;
+        total.fetch_stalls += functions[f].fetch_stalls;
+        total.loads += functions[f].loads;
+        total.stores += functions[f].stores;
+    }
+    total.cycles += fill_cycles;
+
+    printf("Simulation of %s: %lld instruction(s) in %lld cycle(s), CPI %.2f\n", rom_name,
+        total.instructions, total.cycles, total.instructions > 0 ? (double)total.cycles / total.instructions : 0.0);
+    printf("Stalls: %lld data cycle(s), %lld control cycle(s), %lld fetch cycle(s), %lld pipeline fill cycle(s)\n",
+        total.data_stalls, total.control_stalls, total.fetch_stalls, fill_cycles);
+    printf("Memory accesses: %lld load(s), %lld store(s)\n", total.loads, total.stores);
+    printf("%-16s %12s %12s %6s %12s %12s %12s %10s %10s\n", "Function", "Instructions", "Cycles", "CPI",
+        "Data stalls", "Ctrl stalls", "Fetch stalls", "Loads", "Stores");
+    for(int f = 0; f < nb_functions; f++) {
+        if(functions[f].cycles > 0) {
+            sim_report_line(functions[f].name, &functions[f]);
+        }
+    }
+    sim_report_line("(total)", &total);
+}
+
+/* Print the usage of the simulator */
+static void sim_usage(char* program) {
+    fprintf(stderr, "usage: %s [--map=file] [--max-cycles=n] [--trace] [rom, asm.bin by default]\n", program);
+}
+
+int main(int argc, char** argv) {
+    char* rom_file = "asm.bin";
+    char* map_file = NULL;
+    long long max_cycles = SIM_DEFAULT_MAX_CYCLES;
+    bool trace = false;
+    for(int i = 1; i < argc; i++) {
+        if(strncmp(argv[i], "--map=", 6) == 0) {
+            map_file = argv[i] + 6;
+        } else if(strncmp(argv[i], "--max-cycles=", 13) == 0 && atoll(argv[i] + 13) >= 0) {
+            max_cycles = atoll(argv[i] + 13);
+        } else if(strcmp(argv[i], "--trace") == 0) {
+            trace = true;
+        } else if(argv[i][0] != '-') {
+            rom_file = argv[i];
+        } else {
+            fprintf(stderr, "error: unknown option '%s'\n", argv[i]);
+            sim_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if(!sim_load_rom(rom_file)) {
+        return 1;
+    }
+    // The cross assembler writes the map next to the ROM
+    static char default_map[512];
+    if(map_file == NULL) {
+        snprintf(default_map, sizeof(default_map), "%s.map", rom_file);
+        sim_load_map(default_map);
+    } else if(!sim_load_map(map_file)) {
+        fprintf(stderr, "error: cannot read the map '%s'\n", map_file);
+        return 1;
+    }
+
+    bool ok = sim_run(max_cycles, trace);
+    sim_report();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,194 @@
+/**
+ * @file simulator.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the processor simulator
+ *
+ * The simulator runs the ROM written by the cross assembler, see
+ * crossassembler.py, on a model of the pipelined processor, cycle by
+ * cycle, and reports where the cycles go. Each word of the ROM is an
+ * instruction OP A B C, one byte each:
+ * - ADD, SOU, MUL, DIV, EQU, NEQ, LT, LE, GT, GE, AND, OR, SHL, SHR,
+ *   BAND: register A = register B op register C
+ * - NOT: register A = !register B
+ * - COP: register A = register B
+ * - AFC: register A = B
+ * - LOAD: register A = memory[frame + B]
+ * - STORE: memory[frame + A] = register B
+ * - PRI: print memory[frame + A]
+ * - JMP: jump to A
+ * - JMF: jump to B if register A is 0
+ * - ENTER: call A, the new frame starting B slots up
+ * - LEAVE: return from a call, or end the program in the outermost frame
+ * - NOP: no operation
+ *
+ * An operand that does not fit in its byte is replaced by 0 and given in
+ * an extension word following the instruction word, a 32-bit two's
+ * complement value. The bits 7, 6 and 5 of the opcode byte tell if A, B
+ * and C are extended, the extension words come in this order, and the
+ * opcode is in the bits 4 to 0. The addresses of the jumps and calls are
+ * word addresses.
+ *
+ * The return addresses are on a return stack internal to the processor,
+ * as in the interpreter, see instructions_table.h.
+ *
+ * The pipeline has five stages: fetch, decode, execute, memory and write
+ * back. Registers are read in decode and written in write back, in the
+ * first half of the cycle, so an instruction reading a register waits in
+ * decode while an instruction writing it is in execute or memory: two
+ * stall cycles right after the write, one cycle with an instruction in
+ * between. There is no forwarding. JMP, ENTER and LEAVE are taken in
+ * decode and cancel the instruction fetched after them, a JMF is taken
+ * in execute and cancels two. The fetch stage reads one word per cycle,
+ * so an instruction with extension words leaves a bubble behind it for
+ * each of them. The memory is accessed in the memory stage only, in
+ * order, so it causes no hazard.
+ *
+ * The cycles are charged to the function of the instruction leaving the
+ * write back stage, or to the instruction a bubble is inserted for. The
+ * functions are read from the map written next to the ROM, see
+ * sim_load_map.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <stdbool.h> // bool type
+
+/**
+ * @brief Constant for the maximum number of words of the ROM, extension words included
+ */
+#define SIM_ROM_SIZE 65536
+
+/**
+ * @brief Constant for the number of cells of the data memory
+ */
+#define SIM_MEMORY_SIZE 65536
+
+/**
+ * @brief Constant for the mask of the opcode in the opcode byte
+ */
+#define SIM_OPCODE_MASK 0x1f
+
+/**
+ * @brief Constants for the bits of the opcode byte telling that an operand is in an extension word
+ */
+#define SIM_EXTEND_A 0x80
+#define SIM_EXTEND_B 0x40
+#define SIM_EXTEND_C 0x20
+
+/**
+ * @brief Constant for the number of registers
+ */
+#define SIM_NB_REGISTERS 8
+
+/**
+ * @brief Constant for the depth of the return stack
+ */
+#define SIM_RETURN_STACK_SIZE 4096
+
+/**
+ * @brief Constant for the maximum number of functions of the map
+ */
+#define SIM_MAX_FUNCTIONS 256
+
+/**
+ * @brief Constant for the number of cycles after which a run is stopped by default
+ */
+#define SIM_DEFAULT_MAX_CYCLES 100000000
+
+/**
+ * @brief Enumeration of the opcodes of the ROM
+ *
+ * The values are those of the cross assembler.
+ */
+typedef enum {
+    sNOP = 0,
+    sADD = 1,
+    sMUL = 2,
+    sSOU = 3,
+    sDIV = 4,
+    sEQU = 5,
+    sNEQ = 6,
+    sLT = 7,
+    sLE = 8,
+    sGT = 9,
+    sGE = 10,
+    sNOT = 11,
+    sAND = 12,
+    sOR = 13,
+    sJMP = 14,
+    sJMF = 15,
+    sPRI = 16,
+    sENTER = 19,
+    sLEAVE = 20,
+    sAFC = 21,
+    sLOAD = 22,
+    sSTORE = 23,
+    sCOP = 24,
+    sSHL = 25,
+    sSHR = 26,
+    sBAND = 27,
+    SIM_NB_OPCODES
+} sim_opcode;
+
+/**
+ * @brief Enumeration of the stages of the pipeline
+ */
+typedef enum {
+    STAGE_FETCH,
+    STAGE_DECODE,
+    STAGE_EXECUTE,
+    STAGE_MEMORY,
+    STAGE_WRITE_BACK,
+    SIM_NB_STAGES
+} sim_stage;
+
+/**
+ * @brief Read a ROM written by the cross assembler
+ *
+ * Each word is a line (x"OOAABBCC"), the list ends at the others line.
+ * The words are decoded into instructions, with their extension words.
+ *
+ * @param filename the name of the ROM
+ * @return true if the ROM has been read
+ */
+bool sim_load_rom(char* filename);
+
+/**
+ * @brief Read the addresses of the functions of the ROM
+ *
+ * Each line is "address name", in increasing addresses. Without a map,
+ * the whole ROM is a single function.
+ *
+ * @param filename the name of the map
+ * @return true if the map has been read
+ */
+bool sim_load_map(char* filename);
+
+/**
+ * @brief Run the ROM from address 0
+ *
+ * The program ends with a LEAVE in the outermost frame or when it runs
+ * past the end of the ROM. The values printed by PRI go to the standard
+ * output. A division by zero, a division of the smallest integer by -1
+ * or an access out of the memory stops it with an error.
+ *
+ * @param max_cycles the number of cycles after which the run is stopped, 0 for no limit
+ * @param trace true to print the content of the pipeline at each cycle
+ * @return true if the program ended without an error
+ */
+bool sim_run(long long max_cycles, bool trace);
+
+/**
+ * @brief Print the cycles, the CPI, the stalls and the memory accesses of the last run
+ *
+ * The counts are given for the whole program and for each function.
+ */
+void sim_report();
+
+#endif // SIMULATOR_H
@@ -14,8 +14,25 @@ function err() {
 
 make all || (err "step invalid: make")
 
+# A sample may give the options of the compiler on a line "// Options: ..."
 for f in ../samples/*.c; do
     echo "Testing $f" 
-    ./c < $f
+    ./c `sed -n 's|^// Options: ||p' $f` < $f
 done
 
+
+# The passes must not change the values printed by a sample, compared to -O0.
+# A sample still running after a million instructions cannot be compared.
+function values() {
+  python3 interpreter.py --max-iter=1000000 | sed '/Memory at the end/,$d'
+}
+
+for f in ../samples/ok*.c; do
+    ./c -O0 < $f > /dev/null && values > $TMP
+    if grep -q '^Stopped after' $TMP; then
+        echo "Skipping $f, it does not end"
+        continue
+    fi
+    echo "Running $f"
+    ./c `sed -n 's|^// Options: ||p' $f` < $f > /dev/null && values | diff $TMP - > /dev/null || err "step invalid: $f with its options"
+done
@@ -0,0 +1,123 @@
+/**
+ * @file token_stream.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the stream of tokens between the scanner and the parser
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "token_stream.h"
+#include <stdio.h>
+#include <pthread.h>   // pthread_create, pthread_join
+#include <sched.h>     // sched_yield
+#include <stdatomic.h> // atomic_size_t
+#include <time.h>      // clock_gettime
+
+int line_number = 1;
+
+/* Set by --threaded-lexer */
+static bool threaded = false;
+static bool started = false;
+static pthread_t scanner;
+
+/* The ring, the scanner writes head and the parser tail, each on its own cache line */
+static struct_token ring[TS_RING_SIZE];
+static _Alignas(64) atomic_size_t head;
+static _Alignas(64) atomic_size_t tail;
+
+/* Counts of the stages, each written by its own thread */
+static long long nb_scanned = 0, scan_waits = 0;
+static long long nb_parsed = 0, parse_waits = 0;
+static double scan_ms = 0, start_ms = 0;
+
+/* Get the time in milliseconds */
+static double ts_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/* Scan the whole input into the ring */
+static void* ts_scanner(void* unused) {
+    (void)unused;
+    size_t h = 0, cached_tail = 0;
+    struct_token t;
+    do {
+        t.token = ts_scan(&t.value);
+        t.line = scan_line_number;
+        // The index of the parser is read again only when the ring looks full
+        while(h - cached_tail == TS_RING_SIZE) {
+            cached_tail = atomic_load_explicit(&tail, memory_order_acquire);
+            if(h - cached_tail == TS_RING_SIZE) {
+                scan_waits++;
+                sched_yield();
+            }
+        }
+        ring[h % TS_RING_SIZE] = t;
+        atomic_store_explicit(&head, ++h, memory_order_release);
+        nb_scanned++;
+    } while(t.token != 0);
+    scan_ms = ts_now() - start_ms;
+    return NULL;
+}
+
+/* Choose if the scanner runs on its own thread */
+void ts_set_threaded(bool value) {
+    threaded = value;
+}
+
+/* Start the scanner thread, if the scanner runs on its own thread */
+bool ts_start() {
+    if(!threaded) {
+        return true;
+    }
+    atomic_store(&head, 0);
+    atomic_store(&tail, 0);
+    start_ms = ts_now();
+    if(pthread_create(&scanner, NULL, ts_scanner, NULL) != 0) {
+        fprintf(stderr, "error: cannot start the scanner thread\n");
+        return false;
+    }
+    started = true;
+    return true;
+}
+
+/* Get the next token for the parser */
+int yylex() {
+    if(!threaded) {
+        int token = ts_scan(&yylval);
+        line_number = scan_line_number;
+        return token;
+    }
+
+    static size_t t = 0, cached_head = 0;
+    while(t == cached_head) {
+        cached_head = atomic_load_explicit(&head, memory_order_acquire);
+        if(t == cached_head) {
+            parse_waits++;
+            sched_yield();
+        }
+    }
+    struct_token* record = &ring[t % TS_RING_SIZE];
+    yylval = record->value;
+    line_number = record->line;
+    int token = record->token;
+    atomic_store_explicit(&tail, ++t, memory_order_release);
+    nb_parsed++;
+    return token;
+}
+
+/* Wait for the scanner thread and report the throughput of the stages */
+void ts_finish() {
+    if(!started) {
+        return;
+    }
+    pthread_join(scanner, NULL);
+    started = false;
+    double parse_ms = ts_now() - start_ms;
+    printf("Scanner thread: %lld token(s), %d line(s), %.3f ms, %.2f Mtoken/s, %lld wait(s) on a full ring\n",
+        nb_scanned, scan_line_number, scan_ms, scan_ms > 0 ? nb_scanned / scan_ms / 1000.0 : 0.0, scan_waits);
+    printf("Parser and code generation: %lld token(s), %.3f ms, %.2f Mtoken/s, %lld wait(s) on an empty ring\n",
+        nb_parsed, parse_ms, parse_ms > 0 ? nb_parsed / parse_ms / 1000.0 : 0.0, parse_waits);
+}
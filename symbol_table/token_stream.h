@@ -0,0 +1,91 @@
+/**
+ * @file token_stream.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the stream of tokens between the scanner and the parser
+ *
+ * The parser reads its tokens with yylex, which takes them from the
+ * scanner of c.l, ts_scan. By default the scanner runs when the parser
+ * asks for a token, on the same thread.
+ *
+ * With --threaded-lexer, see pass_manager.h, the scanner runs on its own
+ * thread ahead of the parser: it pushes each token, with its value and
+ * the line it ends on, into a ring buffer that the parser pops from. The
+ * ring has one producer and one consumer, so it needs no lock: each side
+ * only writes its own index and publishes it with a release store. A side
+ * that finds the ring full, or empty, yields its core and tries again.
+ * The scanning then overlaps with the parsing and the code generation of
+ * the actions, and the throughput of both stages is reported at the end.
+ *
+ * The scanner counts the lines in its own variable, the parser sees the
+ * line of its last token in line_number.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <stdbool.h> // bool type
+#include "c.tab.h"
+
+/**
+ * @brief Constant for the number of tokens of the ring buffer, a power of two
+ */
+#define TS_RING_SIZE 4096
+
+/**
+ * @brief Structure for a token of the stream
+ *
+ * @param token the token, 0 at the end of the input
+ * @param value the value of the token, for a number or an identifier
+ * @param line the line of the source the scanner was on after the token
+ */
+typedef struct {
+    int token;
+    YYSTYPE value;
+    int line;
+} struct_token;
+
+/**
+ * @brief The line of the last token read by the parser
+ */
+extern int line_number;
+
+/**
+ * @brief The line the scanner is on, defined in c.l
+ */
+extern int scan_line_number;
+
+/**
+ * @brief Scan the next token of the input, defined in c.l
+ *
+ * @param value the value of the token, filled for a number or an identifier
+ * @return int the token, 0 at the end of the input
+ */
+int ts_scan(YYSTYPE* value);
+
+/**
+ * @brief Choose if the scanner runs on its own thread
+ *
+ * @param threaded true to run the scanner on its own thread
+ */
+void ts_set_threaded(bool threaded);
+
+/**
+ * @brief Start the scanner thread, if the scanner runs on its own thread
+ *
+ * @return true if the stream is ready
+ */
+bool ts_start();
+
+/**
+ * @brief Wait for the scanner thread and report the throughput of the stages
+ *
+ * Nothing is done if the scanner runs on the thread of the parser.
+ */
+void ts_finish();
+
+#endif // TOKEN_STREAM_H
@@ -0,0 +1,149 @@
+/**
+ * @file vm_host.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Host of the pool of virtual machines, running ROMs given on the command line or read by a daemon
+ *
+ * With ROMs on the command line, they all run at the same time and their
+ * results are printed in the order of the command line once all have
+ * ended. With --daemon, the names of the ROMs are read from the standard
+ * input, one per line, each ROM runs as soon as its line is read and its
+ * result is printed as soon as it ends, until the end of the input.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "vm_pool.h"
+#include <stdio.h>
+#include <stdlib.h> // atoi, atoll, malloc
+#include <string.h> // strcmp, strncmp, strcspn
+#include <unistd.h> // sysconf
+
+/* Set by --daemon, the results are printed by the workers */
+static bool daemon_mode = false;
+/* Set by --quiet, the outputs of the programs are not printed */
+static bool quiet = false;
+
+/* Counts of the programs that ended, written by the workers */
+static atomic_llong total_instructions;
+static atomic_int nb_ended;
+static atomic_int nb_failed;
+
+/* Print the result of a program */
+static void vh_print(struct_vm_program* program) {
+    char* states[] = {[VP_READY] = "running", [VP_ENDED] = "ended", [VP_STOPPED] = "stopped", [VP_FAILED] = "failed"};
+    flockfile(stdout);
+    printf("== %s #%d: %s%s%s, %lld instruction(s), %lld slice(s), %.3f ms\n", program->name, program->id,
+        states[program->state], program->error[0] != '\0' ? ", " : "", program->error,
+        program->instructions, program->slices, program->end_ms - program->submit_ms);
+    if(!quiet) {
+        fputs(program->output, stdout);
+        if(program->truncated) {
+            printf("(output truncated after %d bytes)\n", program->output_size);
+        }
+    }
+    funlockfile(stdout);
+}
+
+/* Count a program that ended, and print it in daemon mode */
+static void vh_on_end(struct_vm_program* program) {
+    atomic_fetch_add(&total_instructions, program->instructions);
+    atomic_fetch_add(&nb_ended, 1);
+    if(program->state != VP_ENDED) {
+        atomic_fetch_add(&nb_failed, 1);
+    }
+    if(daemon_mode) {
+        vh_print(program);
+        vp_free(program);
+    }
+}
+
+/* Print the usage of the host */
+static void vh_usage(char* program) {
+    fprintf(stderr, "usage: %s [--workers=n] [--fuel=n] [--max-instructions=n] [--quiet] (--daemon | rom...)\n", program);
+}
+
+int main(int argc, char** argv) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int nb_workers = cores < 1 ? 1 : cores > VP_MAX_WORKERS ? VP_MAX_WORKERS : (int)cores;
+    int fuel = VP_DEFAULT_FUEL;
+    long long max_instructions = VP_DEFAULT_MAX_INSTRUCTIONS;
+    char** roms = malloc(sizeof(char*) * argc);
+    int nb_roms = 0;
+    for(int i = 1; i < argc; i++) {
+        if(strncmp(argv[i], "--workers=", 10) == 0) {
+            nb_workers = atoi(argv[i] + 10);
+        } else if(strncmp(argv[i], "--fuel=", 7) == 0) {
+            fuel = atoi(argv[i] + 7);
+        } else if(strncmp(argv[i], "--max-instructions=", 19) == 0 && atoll(argv[i] + 19) >= 0) {
+            max_instructions = atoll(argv[i] + 19);
+        } else if(strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if(strcmp(argv[i], "--daemon") == 0) {
+            daemon_mode = true;
+        } else if(argv[i][0] != '-') {
+            roms[nb_roms++] = argv[i];
+        } else {
+            fprintf(stderr, "error: unknown option '%s'\n", argv[i]);
+            vh_usage(argv[0]);
+            return 1;
+        }
+    }
+    if(daemon_mode == (nb_roms > 0)) {
+        vh_usage(argv[0]);
+        return 1;
+    }
+    if(!vp_start(nb_workers, fuel, vh_on_end)) {
+        return 1;
+    }
+
+    double start_ms = vp_now();
+    int nb_unread = 0;
+    if(daemon_mode) {
+        char line[512];
+        while(fgets(line, sizeof(line), stdin) != NULL) {
+            line[strcspn(line, "\r\n")] = '\0';
+            if(line[0] == '\0') {
+                continue;
+            }
+            struct_vm_program* program = vp_load(line, max_instructions);
+            if(program == NULL) {
+                nb_unread++;
+                continue;
+            }
+            vp_submit(program);
+        }
+        vp_stop();
+    } else {
+        struct_vm_program** programs = malloc(sizeof(struct_vm_program*) * nb_roms);
+        for(int i = 0; i < nb_roms; i++) {
+            programs[i] = vp_load(roms[i], max_instructions);
+            if(programs[i] == NULL) {
+                nb_unread++;
+            }
+        }
+        // The programs are all read before they start, so that they run at the same time
+        for(int i = 0; i < nb_roms; i++) {
+            if(programs[i] != NULL) {
+                vp_submit(programs[i]);
+            }
+        }
+        vp_stop();
+        for(int i = 0; i < nb_roms; i++) {
+            if(programs[i] != NULL) {
+                vh_print(programs[i]);
+                vp_free(programs[i]);
+            }
+        }
+        free(programs);
+    }
+    double ms = vp_now() - start_ms;
+
+    long long instructions = atomic_load(&total_instructions);
+    printf("Pool: %d program(s) on %d worker(s), %d failed or stopped, %d not read, %lld instruction(s) in %.3f ms, %.2f Minstr/s\n",
+        atomic_load(&nb_ended), nb_workers, atomic_load(&nb_failed), nb_unread, instructions, ms,
+        ms > 0 ? instructions / ms / 1000.0 : 0.0);
+    free(roms);
+    return nb_unread > 0 || atomic_load(&nb_failed) > 0 ? 1 : 0;
+}
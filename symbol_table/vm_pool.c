@@ -0,0 +1,520 @@
+/**
+ * @file vm_pool.c
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief Implementation of the pool of virtual machines
+ * @version 0.1
+ * @date 2026-10-19
+ * @bug No known bugs
+ */
+#include "vm_pool.h"
+#include <stdio.h>
+#include <stdint.h>    // intptr_t
+#include <stdlib.h>    // malloc, calloc, realloc, free
+#include <string.h>    // strstr, memcpy
+#include <limits.h>    // INT_MIN
+#include <errno.h>     // EINTR
+#include <pthread.h>   // pthread_create, pthread_join
+#include <sched.h>     // sched_yield
+#include <semaphore.h> // sem_t
+#include <time.h>      // clock_gettime
+
+/* A cell of the queue, free for the turn pos when sequence is pos, full when it is pos + 1 */
+typedef struct {
+    atomic_size_t sequence;
+    struct_vm_program* program;
+} struct_cell;
+
+/* A worker, each on its own cache line since it writes its counts at each slice */
+typedef struct {
+    _Alignas(64) pthread_t thread;
+    long long instructions;
+    long long slices;
+} struct_worker;
+
+/* The queue of the programs ready to run, each side on its own cache line */
+static struct_cell cells[VP_MAX_PROGRAMS];
+static _Alignas(64) atomic_size_t enqueue_pos;
+static _Alignas(64) atomic_size_t dequeue_pos;
+
+/* The number of programs in the queue, and the programs that ended since the host last waited */
+static sem_t ready;
+static sem_t ended;
+
+/* The programs submitted and not ended, counted by the host and the workers */
+static _Alignas(64) atomic_int live;
+static atomic_bool stopping;
+
+static struct_worker workers[VP_MAX_WORKERS];
+static int nb_workers = 0;
+static int slice_fuel = VP_DEFAULT_FUEL;
+static vp_callback callback = NULL;
+static int next_id = 0;
+
+/* Get the time in milliseconds */
+double vp_now() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/* Put a program at the end of the queue, false if the queue is full */
+static bool vp_push(struct_vm_program* program) {
+    size_t pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+    struct_cell* cell;
+    while(true) {
+        cell = &cells[pos % VP_MAX_PROGRAMS];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if(diff == 0) {
+            if(atomic_compare_exchange_weak_explicit(&enqueue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&enqueue_pos, memory_order_relaxed);
+        }
+    }
+    cell->program = program;
+    atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+/* Take the program at the start of the queue, NULL if none is ready */
+static struct_vm_program* vp_pop() {
+    size_t pos = atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+    struct_cell* cell;
+    while(true) {
+        cell = &cells[pos % VP_MAX_PROGRAMS];
+        size_t sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if(diff == 0) {
+            if(atomic_compare_exchange_weak_explicit(&dequeue_pos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if(diff < 0) {
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&dequeue_pos, memory_order_relaxed);
+        }
+    }
+    struct_vm_program* program = cell->program;
+    // The cell is free again for the next turn
+    atomic_store_explicit(&cell->sequence, pos + VP_MAX_PROGRAMS, memory_order_release);
+    return program;
+}
+
+/* Wait on a semaphore, again if interrupted by a signal */
+static void vp_sem_wait(sem_t* semaphore) {
+    while(sem_wait(semaphore) != 0 && errno == EINTR) {
+    }
+}
+
+/* Stop a program on an error */
+static void vp_fail(struct_vm_program* program, char* reason, int pc) {
+    program->state = VP_FAILED;
+    snprintf(program->error, sizeof(program->error), "%s at %d", reason, pc);
+}
+
+/* Add a value printed by PRI to the output of a program */
+static void vp_print(struct_vm_program* program, int value) {
+    if(program->truncated) {
+        return;
+    }
+    char text[16];
+    int length = snprintf(text, sizeof(text), "%d\n", value);
+    if(program->output_size + length > VP_OUTPUT_LIMIT) {
+        program->truncated = true;
+        return;
+    }
+    if(program->output_size + length + 1 > program->output_capacity) {
+        int capacity = program->output_capacity * 2;
+        char* output = realloc(program->output, capacity);
+        if(output == NULL) {
+            program->truncated = true;
+            return;
+        }
+        program->output = output;
+        program->output_capacity = capacity;
+    }
+    memcpy(program->output + program->output_size, text, length + 1);
+    program->output_size += length;
+}
+
+/* Run a program for at most fuel instructions, returns the number of instructions run */
+static int vp_slice(struct_vm_program* program, int fuel) {
+    int* r = program->registers;
+    int* memory = program->memory;
+    int pc = program->pc, frame = program->frame;
+    int n = 0;
+    while(n < fuel && program->state == VP_READY) {
+        if(pc < 0 || pc >= program->size) {
+            // Past the end of the ROM
+            program->state = VP_ENDED;
+            break;
+        }
+        struct_vm_word* w = &program->code[pc];
+        int address;
+        n++;
+        pc += w->size;
+        switch(w->opcode) {
+            case sNOP: break;
+            // The operations wrap around, computed in unsigned as signed overflows are undefined
+            case sADD: r[w->a] = (int)((unsigned int)r[w->b] + (unsigned int)r[w->c]); break;
+            case sSOU: r[w->a] = (int)((unsigned int)r[w->b] - (unsigned int)r[w->c]); break;
+            case sMUL: r[w->a] = (int)((unsigned int)r[w->b] * (unsigned int)r[w->c]); break;
+            case sDIV:
+                if(r[w->c] == 0) {
+                    vp_fail(program, "division by zero", pc - w->size);
+                    break;
+                }
+                if(r[w->b] == INT_MIN && r[w->c] == -1) {
+                    // The quotient does not fit, and the host would trap on it
+                    vp_fail(program, "division overflow", pc - w->size);
+                    break;
+                }
+                r[w->a] = r[w->b] / r[w->c];
+                break;
+            case sEQU: r[w->a] = r[w->b] == r[w->c]; break;
+            case sNEQ: r[w->a] = r[w->b] != r[w->c]; break;
+            case sLT: r[w->a] = r[w->b] < r[w->c]; break;
+            case sLE: r[w->a] = r[w->b] <= r[w->c]; break;
+            case sGT: r[w->a] = r[w->b] > r[w->c]; break;
+            case sGE: r[w->a] = r[w->b] >= r[w->c]; break;
+            case sAND: r[w->a] = r[w->b] && r[w->c]; break;
+            case sOR: r[w->a] = r[w->b] || r[w->c]; break;
+            case sNOT: r[w->a] = !r[w->b]; break;
+            case sSHL: r[w->a] = (int)((unsigned int)r[w->b] << (r[w->c] & 31)); break;
+            case sSHR: r[w->a] = r[w->b] >> (r[w->c] & 31); break;
+            case sBAND: r[w->a] = r[w->b] & r[w->c]; break;
+            case sCOP: r[w->a] = r[w->b]; break;
+            case sAFC: r[w->a] = w->b; break;
+            case sLOAD:
+                address = frame + w->b;
+                if(address < 0 || address >= SIM_MEMORY_SIZE) {
+                    vp_fail(program, "address out of the memory", pc - w->size);
+                    break;
+                }
+                r[w->a] = memory[address];
+                break;
+            case sSTORE:
+                address = frame + w->a;
+                if(address < 0 || address >= SIM_MEMORY_SIZE) {
+                    vp_fail(program, "address out of the memory", pc - w->size);
+                    break;
+                }
+                memory[address] = r[w->b];
+                break;
+            case sPRI:
+                address = frame + w->a;
+                if(address < 0 || address >= SIM_MEMORY_SIZE) {
+                    vp_fail(program, "address out of the memory", pc - w->size);
+                    break;
+                }
+                vp_print(program, memory[address]);
+                break;
+            case sJMP: pc = w->a; break;
+            case sJMF:
+                if(r[w->a] == 0) {
+                    pc = w->b;
+                }
+                break;
+            case sENTER:
+                if(program->nb_returns == SIM_RETURN_STACK_SIZE) {
+                    vp_fail(program, "stack overflow", pc - w->size);
+                    break;
+                }
+                program->return_pc[program->nb_returns] = pc;
+                program->return_frame[program->nb_returns++] = frame;
+                frame += w->b;
+                pc = w->a;
+                break;
+            case sLEAVE:
+                if(program->nb_returns == 0) {
+                    program->state = VP_ENDED;
+                    break;
+                }
+                program->nb_returns--;
+                pc = program->return_pc[program->nb_returns];
+                frame = program->return_frame[program->nb_returns];
+                break;
+            default:
+                vp_fail(program, "jump into an extension word", pc - w->size);
+                break;
+        }
+    }
+    program->pc = pc;
+    program->frame = frame;
+    return n;
+}
+
+/* Take the end of a program into account */
+static void vp_end(struct_vm_program* program) {
+    program->end_ms = vp_now();
+    if(callback != NULL) {
+        callback(program);
+    }
+    // The program may have been freed by the callback
+    atomic_fetch_sub_explicit(&live, 1, memory_order_release);
+    sem_post(&ended);
+}
+
+/* Run slices of the programs of the queue until the pool stops */
+static void* vp_worker(void* arg) {
+    struct_worker* worker = arg;
+    while(true) {
+        vp_sem_wait(&ready);
+        if(atomic_load_explicit(&stopping, memory_order_acquire)) {
+            break;
+        }
+        // The program counted by the semaphore may still be being pushed
+        struct_vm_program* program;
+        while((program = vp_pop()) == NULL) {
+            sched_yield();
+        }
+
+        int fuel = slice_fuel;
+        if(program->max_instructions > 0 && program->max_instructions - program->instructions < fuel) {
+            fuel = (int)(program->max_instructions - program->instructions);
+        }
+        int n = vp_slice(program, fuel);
+        program->instructions += n;
+        program->slices++;
+        worker->instructions += n;
+        worker->slices++;
+        if(program->state == VP_READY && program->max_instructions > 0 && program->instructions >= program->max_instructions) {
+            program->state = VP_STOPPED;
+            snprintf(program->error, sizeof(program->error), "over the limit of %lld instructions", program->max_instructions);
+        }
+
+        if(program->state != VP_READY) {
+            vp_end(program);
+        } else if(vp_push(program)) {
+            sem_post(&ready);
+        } else {
+            // Never happens, there are never more programs than cells
+            vp_fail(program, "queue full", program->pc);
+            vp_end(program);
+        }
+    }
+    return NULL;
+}
+
+/* Start the workers of the pool */
+bool vp_start(int count, int fuel, vp_callback on_end) {
+    if(count < 1 || count > VP_MAX_WORKERS || fuel < 1) {
+        fprintf(stderr, "error: between 1 and %d workers and a positive fuel are needed\n", VP_MAX_WORKERS);
+        return false;
+    }
+    for(int i = 0; i < VP_MAX_PROGRAMS; i++) {
+        atomic_init(&cells[i].sequence, i);
+    }
+    atomic_init(&enqueue_pos, 0);
+    atomic_init(&dequeue_pos, 0);
+    atomic_init(&live, 0);
+    atomic_init(&stopping, false);
+    sem_init(&ready, 0, 0);
+    sem_init(&ended, 0, 0);
+    slice_fuel = fuel;
+    callback = on_end;
+    next_id = 0;
+
+    for(nb_workers = 0; nb_workers < count; nb_workers++) {
+        struct_worker* worker = &workers[nb_workers];
+        worker->instructions = worker->slices = 0;
+        if(pthread_create(&worker->thread, NULL, vp_worker, worker) != 0) {
+            fprintf(stderr, "error: cannot start the worker %d\n", nb_workers);
+            vp_stop();
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Get the registers used by an instruction, returns their number, -1 for an unknown opcode */
+static int vp_registers(struct_vm_word w, int* regs) {
+    switch(w.opcode) {
+        case sNOP: case sJMP: case sPRI: case sENTER: case sLEAVE:
+            return 0;
+        case sAFC: case sLOAD: case sJMF:
+            regs[0] = w.a;
+            return 1;
+        case sSTORE:
+            regs[0] = w.b;
+            return 1;
+        case sNOT: case sCOP:
+            regs[0] = w.a;
+            regs[1] = w.b;
+            return 2;
+        case sADD: case sSOU: case sMUL: case sDIV: case sEQU: case sNEQ: case sLT: case sLE:
+        case sGT: case sGE: case sAND: case sOR: case sSHL: case sSHR: case sBAND:
+            regs[0] = w.a;
+            regs[1] = w.b;
+            regs[2] = w.c;
+            return 3;
+        default:
+            return -1;
+    }
+}
+
+/* Read a ROM written by the cross assembler into a new program */
+struct_vm_program* vp_load(char* filename, long long max_instructions) {
+    FILE* file = fopen(filename, "r");
+    if(file == NULL) {
+        fprintf(stderr, "error: cannot read the ROM '%s'\n", filename);
+        return NULL;
+    }
+    struct_vm_program* program = calloc(1, sizeof(struct_vm_program));
+    unsigned int* words = malloc(sizeof(unsigned int) * SIM_ROM_SIZE);
+    int* lines = malloc(sizeof(int) * SIM_ROM_SIZE);
+    if(program == NULL || words == NULL || lines == NULL) {
+        fprintf(stderr, "error: out of memory for '%s'\n", filename);
+        fclose(file);
+        free(program);
+        free(words);
+        free(lines);
+        return NULL;
+    }
+    snprintf(program->name, sizeof(program->name), "%s", filename);
+    program->max_instructions = max_instructions;
+
+    bool ok = true;
+    char line[256];
+    int line_number = 0;
+    while(ok && fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        if(strstr(line, "others") != NULL) {
+            break;
+        }
+        char* word = strstr(line, "x\"");
+        if(word == NULL) {
+            continue;
+        }
+        unsigned int value;
+        int length = 0;
+        if(sscanf(word + 2, "%8x%n", &value, &length) != 1 || length != 8 || word[2 + length] != '"') {
+            fprintf(stderr, "error: %s:%d: malformed word\n", filename, line_number);
+            ok = false;
+        } else if(program->size == SIM_ROM_SIZE) {
+            fprintf(stderr, "error: %s: more than %d words\n", filename, SIM_ROM_SIZE);
+            ok = false;
+        } else {
+            lines[program->size] = line_number;
+            words[program->size++] = value;
+        }
+    }
+    fclose(file);
+
+    // Decode the instructions, an extended operand takes the next word
+    program->code = malloc(sizeof(struct_vm_word) * (program->size > 0 ? program->size : 1));
+    ok = ok && program->code != NULL;
+    for(int i = 0; ok && i < program->size; ) {
+        unsigned int value = words[i];
+        int opcode = value >> 24;
+        int fields[3] = {(value >> 16) & 0xff, (value >> 8) & 0xff, value & 0xff};
+        int flags[3] = {SIM_EXTEND_A, SIM_EXTEND_B, SIM_EXTEND_C};
+        int size = 1;
+        for(int k = 0; ok && k < 3; k++) {
+            if(opcode & flags[k]) {
+                if(i + size == program->size) {
+                    fprintf(stderr, "error: %s:%d: missing extension word\n", filename, lines[i]);
+                    ok = false;
+                } else {
+                    fields[k] = (int)words[i + size++];
+                }
+            }
+        }
+        struct_vm_word w = {opcode & SIM_OPCODE_MASK, fields[0], fields[1], fields[2], size};
+        int regs[3];
+        int nb_regs = ok ? vp_registers(w, regs) : 0;
+        bool bad_register = false;
+        for(int r = 0; r < nb_regs; r++) {
+            bad_register |= regs[r] < 0 || regs[r] >= SIM_NB_REGISTERS;
+        }
+        if(!ok) {
+            break;
+        } else if(nb_regs == -1) {
+            fprintf(stderr, "error: %s:%d: unknown opcode %d\n", filename, lines[i], w.opcode);
+            ok = false;
+        } else if(bad_register) {
+            // The registers are checked here so that a slice does not check them
+            fprintf(stderr, "error: %s:%d: no such register\n", filename, lines[i]);
+            ok = false;
+        } else {
+            program->code[i] = w;
+            for(int k = 1; k < size; k++) {
+                program->code[i + k].opcode = -1;
+                program->code[i + k].size = 1;
+            }
+            i += size;
+        }
+    }
+    free(words);
+    free(lines);
+
+    program->memory = calloc(SIM_MEMORY_SIZE, sizeof(int));
+    program->return_pc = malloc(sizeof(int) * SIM_RETURN_STACK_SIZE);
+    program->return_frame = malloc(sizeof(int) * SIM_RETURN_STACK_SIZE);
+    program->output_capacity = 256;
+    program->output = malloc(program->output_capacity);
+    if(ok && (program->memory == NULL || program->return_pc == NULL || program->return_frame == NULL || program->output == NULL)) {
+        fprintf(stderr, "error: out of memory for '%s'\n", filename);
+        ok = false;
+    }
+    if(!ok) {
+        vp_free(program);
+        return NULL;
+    }
+    program->output[0] = '\0';
+    program->state = VP_READY;
+    return program;
+}
+
+/* Queue a program to run from address 0 */
+void vp_submit(struct_vm_program* program) {
+    while(atomic_load_explicit(&live, memory_order_acquire) == VP_MAX_PROGRAMS) {
+        vp_sem_wait(&ended);
+    }
+    atomic_fetch_add_explicit(&live, 1, memory_order_relaxed);
+    program->id = next_id++;
+    program->submit_ms = vp_now();
+    vp_push(program);
+    sem_post(&ready);
+}
+
+/* Wait for all the programs submitted to end */
+void vp_wait() {
+    while(atomic_load_explicit(&live, memory_order_acquire) > 0) {
+        vp_sem_wait(&ended);
+    }
+}
+
+/* Stop the workers, once all the programs have ended */
+void vp_stop() {
+    vp_wait();
+    atomic_store_explicit(&stopping, true, memory_order_release);
+    for(int w = 0; w < nb_workers; w++) {
+        sem_post(&ready);
+    }
+    for(int w = 0; w < nb_workers; w++) {
+        pthread_join(workers[w].thread, NULL);
+        printf("Worker %d: %lld instruction(s) in %lld slice(s)\n", w, workers[w].instructions, workers[w].slices);
+    }
+    nb_workers = 0;
+    sem_destroy(&ready);
+    sem_destroy(&ended);
+}
+
+/* Free a program that has ended */
+void vp_free(struct_vm_program* program) {
+    if(program == NULL) {
+        return;
+    }
+    free(program->code);
+    free(program->memory);
+    free(program->return_pc);
+    free(program->return_frame);
+    free(program->output);
+    free(program);
+}
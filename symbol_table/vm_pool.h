@@ -0,0 +1,220 @@
+/**
+ * @file vm_pool.h
+ * @author Ronan Bonnet
+ * @author Anna Cazeneuve
+ * @brief This file contains the prototypes for the pool of virtual machines
+ *
+ * The pool runs many ROMs written by the cross assembler at the same
+ * time, on a fixed number of worker threads. The instructions are those
+ * of the processor, see simulator.h, but they are executed one after the
+ * other, without the pipeline.
+ *
+ * Each program has its own registers, return stack, frame memory and
+ * output buffer, so the programs never share data and their outputs are
+ * never mixed: a PRI writes to the buffer of its program, which the host
+ * reads once the program has ended.
+ *
+ * The programs ready to run wait in a queue. A worker takes a program,
+ * runs it for a slice of at most fuel instructions, then puts it back at
+ * the end of the queue if it has not ended. A program looping for a long
+ * time only gets its share of the workers, and the other programs keep
+ * running between its slices. A program running more instructions than
+ * its limit is stopped. A program dividing by zero, dividing the
+ * smallest integer by -1 or reaching out of its memory fails, and the
+ * others keep running.
+ *
+ * The queue is a bounded array of cells, each with a sequence number
+ * telling if it is free or full for the current turn. A thread claims a
+ * cell with a compare and swap on the index of its side, and publishes
+ * it with a release store of the sequence, so no lock is taken. The
+ * workers count the ready programs with a semaphore, which only goes to
+ * the kernel when a worker has nothing to run.
+ *
+ * The host calls vp_start, vp_load and vp_submit for each program, then
+ * vp_wait and vp_stop. The pool and the programs are used from a single
+ * host thread, except for the callback called by the workers when a
+ * program ends.
+ *
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @bug No known bugs
+ */
+#ifndef VM_POOL_H
+#define VM_POOL_H
+
+#include <stdbool.h>   // bool type
+#include <stdatomic.h> // atomic_int
+#include "simulator.h"
+
+/**
+ * @brief Constant for the maximum number of workers
+ */
+#define VP_MAX_WORKERS 64
+
+/**
+ * @brief Constant for the maximum number of programs submitted and not ended, a power of two
+ */
+#define VP_MAX_PROGRAMS 1024
+
+/**
+ * @brief Constant for the number of instructions of a slice by default
+ */
+#define VP_DEFAULT_FUEL 10000
+
+/**
+ * @brief Constant for the number of instructions after which a program is stopped by default
+ */
+#define VP_DEFAULT_MAX_INSTRUCTIONS 100000000
+
+/**
+ * @brief Constant for the maximum number of bytes of the output of a program
+ */
+#define VP_OUTPUT_LIMIT (1 << 20)
+
+/**
+ * @brief Enumeration of the states of a program
+ */
+typedef enum {
+    VP_READY,
+    VP_ENDED,
+    VP_STOPPED,
+    VP_FAILED
+} vp_state;
+
+/**
+ * @brief Structure for an instruction of a program, decoded with its extension words
+ *
+ * @param opcode the opcode, -1 for an extension word
+ * @param a the first operand
+ * @param b the second operand
+ * @param c the third operand
+ * @param size the number of words of the instruction
+ */
+typedef struct {
+    int opcode;
+    int a;
+    int b;
+    int c;
+    int size;
+} struct_vm_word;
+
+/**
+ * @brief Structure for a program of the pool
+ *
+ * Only the worker running a slice of the program writes it, the host
+ * reads it once the program has ended.
+ *
+ * @param name the name of the ROM
+ * @param id the number of the program, in the order of submission
+ * @param code the decoded instructions
+ * @param size the number of words of the ROM
+ * @param registers the registers
+ * @param memory the frame memory, of SIM_MEMORY_SIZE cells
+ * @param return_pc the return addresses of the calls
+ * @param return_frame the frames of the callers
+ * @param nb_returns the number of calls in progress
+ * @param pc the address of the next instruction
+ * @param frame the start of the frame of the current function
+ * @param output the values printed, one per line
+ * @param output_size the number of bytes of the output
+ * @param output_capacity the number of bytes allocated for the output
+ * @param truncated true if the output went past VP_OUTPUT_LIMIT
+ * @param state the state of the program
+ * @param error the reason the program failed
+ * @param instructions the number of instructions run
+ * @param max_instructions the number of instructions after which the program is stopped, 0 for no limit
+ * @param slices the number of slices run
+ * @param submit_ms the time of the submission
+ * @param end_ms the time the program ended
+ */
+typedef struct {
+    char name[256];
+    int id;
+    struct_vm_word* code;
+    int size;
+    int registers[SIM_NB_REGISTERS];
+    int* memory;
+    int* return_pc;
+    int* return_frame;
+    int nb_returns;
+    int pc;
+    int frame;
+    char* output;
+    int output_size;
+    int output_capacity;
+    bool truncated;
+    vp_state state;
+    char error[128];
+    long long instructions;
+    long long max_instructions;
+    long long slices;
+    double submit_ms;
+    double end_ms;
+} struct_vm_program;
+
+/**
+ * @brief Type of the function called by a worker when a program ends
+ *
+ * It runs on the worker, possibly at the same time as for another
+ * program on another worker.
+ */
+typedef void (*vp_callback)(struct_vm_program* program);
+
+/**
+ * @brief Start the workers of the pool
+ *
+ * @param nb_workers the number of workers, at most VP_MAX_WORKERS
+ * @param fuel the maximum number of instructions of a slice
+ * @param on_end the function called when a program ends, NULL for none
+ * @return true if the workers have been started
+ */
+bool vp_start(int nb_workers, int fuel, vp_callback on_end);
+
+/**
+ * @brief Read a ROM written by the cross assembler into a new program
+ *
+ * Each word is a line (x"OOAABBCC"), the list ends at the others line.
+ *
+ * @param filename the name of the ROM
+ * @param max_instructions the number of instructions after which the program is stopped, 0 for no limit
+ * @return struct_vm_program* the program, NULL if the ROM cannot be read
+ */
+struct_vm_program* vp_load(char* filename, long long max_instructions);
+
+/**
+ * @brief Queue a program to run from address 0
+ *
+ * Waits for a program to end if VP_MAX_PROGRAMS programs are running.
+ *
+ * @param program the program, owned by the pool until it ends
+ */
+void vp_submit(struct_vm_program* program);
+
+/**
+ * @brief Wait for all the programs submitted to end
+ */
+void vp_wait();
+
+/**
+ * @brief Stop the workers, once all the programs have ended
+ *
+ * The number of instructions and slices run by each worker is printed.
+ */
+void vp_stop();
+
+/**
+ * @brief Free a program that has ended
+ *
+ * @param program the program
+ */
+void vp_free(struct_vm_program* program);
+
+/**
+ * @brief Get the time in milliseconds, on the clock of the pool
+ *
+ * @return double the time
+ */
+double vp_now();
+
+#endif // VM_POOL_H